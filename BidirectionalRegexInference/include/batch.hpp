@@ -0,0 +1,35 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <rei.hpp>
+
+namespace rei {
+
+    enum class BatchFormat { CSV, JSONLines };
+
+    struct BatchConfigs {
+        int threads = 1;
+        // memory budget of a single job in bytes, 0 keeps the default cache capacities
+        size_t jobMemory = 0;
+        BatchFormat format = BatchFormat::CSV;
+        DedupeMode dedupe = DedupeMode::Exact;
+        // directory of the guide table cache shared by the workers, empty to build every table
+        std::string guideTableCache;
+    };
+
+    // return the example files of a directory (*.txt, natural order) or the files listed in a text file
+    std::vector<std::string> collectBatchFiles(const std::string& source);
+
+    /// <summary>
+    /// run the inference on every file with a pool of worker threads, each worker reuse the same solver
+    /// for all of its jobs. a record is written to the output as soon as its job is done
+    /// </summary>
+    void RunBatch(const std::vector<std::string>& files, const unsigned short* costFun, const unsigned short maxCost,
+        const BatchConfigs& configs, std::ostream& out);
+}
+
+#endif // BATCH_HPP
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <functional>
 #include <bit>
+#include <type_traits>
 #include <pair.h>
 
 template <class T>
@@ -15,36 +16,45 @@ using Pair = rei::Pair<T>;
 
 namespace rei
 {
+    /// <summary>
+    /// 128 bit summary of a bitmask, stored instead of the mask when the dedupe may be approximate
+    /// </summary>
+    struct Fingerprint {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        HD constexpr bool operator==(const Fingerprint& other) const = default;
+    };
+
     /// <summary>
     /// bitmask template implementation, work on both host and device and implement (RUC), the number of bits is N*64
     /// </summary>
     template <int N>
     struct bitmask {
 
-        HD bitmask(const uint64_t(&input)[N]) {
+        HD constexpr bitmask(const uint64_t(&input)[N]) {
             for (size_t i = 0; i < N; ++i) {
                 data[i] = input[i];
             }
         }
 
-        HD bitmask() {
-            for (size_t i = 0; i < N; ++i) {
-                data[i] = 0;
-            }
-        }
+        HD constexpr bitmask() : data{} {}
 
-        HD bitmask(const bitmask& other) {
-            for (size_t i = 0; i < N; ++i)
-                data[i] = other.data[i];
-        }
+        // the copies are plain word copies, so vectors of CS are moved with memcpy
+        HD constexpr bitmask(const bitmask& other) = default;
+        HD constexpr bitmask(bitmask&& other) noexcept = default;
+        HD constexpr bitmask& operator=(const bitmask& other) = default;
+        HD constexpr bitmask& operator=(bitmask&& other) noexcept = default;
+
+        static constexpr int Words = N;
 
-        HD bitmask(bitmask&& other) noexcept {
-            for (size_t i = 0; i < N; ++i)
-                data[i] = other.data[i];
-            for (size_t i = 0; i < N; ++i) other.data[i] = 0;
+        // number of words that hold the first `bits` bits, the rest stay zero for a problem of that size
+        HD static constexpr int wordsFor(int bits) {
+            int words = (bits + 63) / 64;
+            return words < 1 ? 1 : (words > N ? N : words);
         }
 
-        HD static bitmask all() {
+        HD static constexpr bitmask all() {
             uint64_t vals[N];
             for (size_t i = 0; i < N; ++i) {
                 vals[i] = (uint64_t)-1;
@@ -52,19 +62,32 @@ namespace rei
             return bitmask(vals);
         }
 
-        HD static bitmask one() {
+        HD static constexpr bitmask one() {
             uint64_t vals[N] = {};
             vals[0] = 1;
             return bitmask(vals);
         }
 
-        HD static bitmask fromLow(uint64_t lowBits) {
+        HD static constexpr bitmask fromLow(uint64_t lowBits) {
             uint64_t vals[N] = {};
             vals[0] = lowBits;
             return bitmask(vals);
         }
 
-        HD Pair<uint64_t> get128Hash() const {
+        // two independent multiply-rotate lanes over every word (the xxHash round) with a murmur finalizer,
+        // a flipped bit anywhere changes both halves. this is also the hash of the hash tables
+        HD constexpr Fingerprint fingerprint() const {
+            uint64_t a = UINT64_C(0x9e3779b97f4a7c15), b = UINT64_C(0xc2b2ae3d27d4eb4f);
+            for (int i = 0; i < N; ++i) {
+                a = std::rotl(a + data[i] * UINT64_C(0xc2b2ae3d27d4eb4f), 31) * UINT64_C(0x9e3779b97f4a7c15);
+                b = std::rotl(b + (data[i] ^ UINT64_C(0x165667b19e3779f9)) * UINT64_C(0x27d4eb2f165667c5), 27) * UINT64_C(0x85ebca77c2b2ae63);
+            }
+            a = fmix(a ^ N);
+            b = fmix(b + a);
+            return { b, a };
+        }
+
+        HD constexpr Pair<uint64_t> get128Hash() const {
 
             if (N == 2) 
             { return { data[1], data[0] }; }
@@ -127,19 +150,7 @@ namespace rei
             return { hCS, lCS };
         }
 
-        HD bitmask& operator=(const bitmask& other) {
-            if (this != &other)
-                for (size_t i = 0; i < N; ++i) data[i] = other.data[i];
-            return *this;
-        }
-
-        HD bitmask& operator=(bitmask&& other) noexcept {
-            if (this != &other)
-                for (size_t i = 0; i < N; ++i) data[i] = other.data[i];
-            return *this;
-        }
-
-        HD bitmask operator|(const bitmask& solved) const {
+        HD constexpr bitmask operator|(const bitmask& solved) const {
             uint64_t vals[N];
             for (size_t i = 0; i < N; ++i) {
                 vals[i] = data[i] | solved.data[i];
@@ -147,14 +158,14 @@ namespace rei
             return bitmask(vals);
         }
 
-        HD bitmask& operator|=(const bitmask& solved) {
+        HD constexpr bitmask& operator|=(const bitmask& solved) {
             for (size_t i = 0; i < N; ++i) {
                 data[i] |= solved.data[i];
             }
             return *this;
         }
 
-        HD bitmask operator^(const bitmask& solved) const {
+        HD constexpr bitmask operator^(const bitmask& solved) const {
             uint64_t vals[N];
             for (size_t i = 0; i < N; ++i) {
                 vals[i] = data[i] ^ solved.data[i];
@@ -162,14 +173,14 @@ namespace rei
             return bitmask(vals);
         }
 
-        HD bitmask& operator^=(const bitmask& solved) {
+        HD constexpr bitmask& operator^=(const bitmask& solved) {
             for (size_t i = 0; i < N; ++i) {
                 data[i] ^= solved.data[i];
             }
             return *this;
         }
 
-        HD bitmask operator&(const bitmask& solved) const {
+        HD constexpr bitmask operator&(const bitmask& solved) const {
             uint64_t vals[N];
             for (size_t i = 0; i < N; ++i) {
                 vals[i] = data[i] & solved.data[i];
@@ -177,14 +188,14 @@ namespace rei
             return bitmask(vals);
         }
 
-        HD bitmask& operator&=(const bitmask& solved) {
+        HD constexpr bitmask& operator&=(const bitmask& solved) {
             for (size_t i = 0; i < N; ++i) {
                 data[i] &= solved.data[i];
             }
             return *this;
         }
 
-        HD bitmask operator<<(const int shift) const {
+        HD constexpr bitmask operator<<(const int shift) const {
             uint64_t vals[N] = {};
 
             if (shift < 0) {
@@ -207,7 +218,7 @@ namespace rei
 
             return bitmask(vals);
         }
-        HD bitmask& operator<<=(int shift) {
+        HD constexpr bitmask& operator<<=(int shift) {
 
             if (shift < 0) {
                 return *this >>= -shift;
@@ -240,7 +251,7 @@ namespace rei
             return *this;
         }
 
-        HD bitmask operator>>(const int shift) const {
+        HD constexpr bitmask operator>>(const int shift) const {
 
             uint64_t vals[N] = {};
 
@@ -265,7 +276,7 @@ namespace rei
 
             return bitmask(vals);
         }
-        HD bitmask& operator>>=(int shift) {
+        HD constexpr bitmask& operator>>=(int shift) {
 
             if (shift < 0) {
                 return *this <<= -shift;
@@ -298,7 +309,7 @@ namespace rei
             return *this;
         }
 
-        HD bitmask operator~() const {
+        HD constexpr bitmask operator~() const {
             uint64_t vals[N];
             for (size_t i = 0; i < N; ++i) {
                 vals[i] = ~data[i];
@@ -306,31 +317,31 @@ namespace rei
             return bitmask(vals);
         }
 
-        HD bool operator==(const bitmask& solved) const {
+        HD constexpr bool operator==(const bitmask& solved) const {
             for (size_t i = 0; i < N; ++i) {
                 if (data[i] != solved.data[i]) { return false; }
             }
             return true;
         }
-        HD bool operator!=(const bitmask& solved) const {
+        HD constexpr bool operator!=(const bitmask& solved) const {
             for (size_t i = 0; i < N; ++i) {
                 if (data[i] != solved.data[i]) { return true; }
             }
             return false;
         }
 
-        HD inline operator bool() const {
+        HD constexpr operator bool() const {
             for (size_t i = 0; i < N; ++i) {
                 if (data[i] != 0) { return true; }
             }
             return false;
         }
 
-        HD inline bool operator!() const {
+        HD constexpr bool operator!() const {
             return !static_cast<bool>(*this);
         }
 
-        bitmask& operator--() {
+        constexpr bitmask& operator--() {
             for (size_t i = 0; i < N; ++i) {
                 if (data[i] != 0) {
                     --data[i];
@@ -342,13 +353,13 @@ namespace rei
             return *this;
         }
 
-        bitmask operator--(int) {
+        constexpr bitmask operator--(int) {
             bitmask temp = *this;
             --(*this);
             return temp;
         }
 
-        bitmask& operator++() {
+        constexpr bitmask& operator++() {
             for (size_t i = 0; i < N; ++i) {
                 ++data[i];
                 if (data[i] != 0) {
@@ -358,13 +369,13 @@ namespace rei
             return *this;
         }
 
-        bitmask operator++(int) {
+        constexpr bitmask operator++(int) {
             bitmask temp = *this;
             ++(*this);
             return temp;
         }
 
-        bool operator>(const bitmask& solved) const {
+        constexpr bool operator>(const bitmask& solved) const {
             for (int i = N - 1; i >= 0; --i) {
                 if (data[i] > solved.data[i]) return true;
                 if (data[i] < solved.data[i]) return false;
@@ -372,15 +383,15 @@ namespace rei
             return false;
         }
 
-        bool operator>=(const bitmask& solved) const {
+        constexpr bool operator>=(const bitmask& solved) const {
             return !(*this < solved);
         }
 
-        bool operator<=(const bitmask& solved) const {
+        constexpr bool operator<=(const bitmask& solved) const {
             return !(*this > solved);
         }
 
-        bool operator<(const bitmask& solved) const {
+        constexpr bool operator<(const bitmask& solved) const {
             for (int i = N - 1; i >= 0; --i) {
                 if (data[i] < solved.data[i]) return true;
                 if (data[i] > solved.data[i]) return false;
@@ -397,13 +408,99 @@ namespace rei
             return os;
         }
 
-        uint64_t popCount() const {
+        // single bit access without building a shifted mask, a mask costs N words on wide sets
+        HD constexpr bool test(int bit) const {
+            return (data[bit >> 6] >> (bit & 63)) & 1;
+        }
+
+        HD constexpr void set(int bit) {
+            data[bit >> 6] |= (uint64_t)1 << (bit & 63);
+        }
+
+        HD constexpr uint64_t word(int i) const {
+            return data[i];
+        }
+
+        HD constexpr void setWord(int i, uint64_t value) {
+            data[i] = value;
+        }
+
+        HD constexpr void orWord(int i, uint64_t value) {
+            data[i] |= value;
+        }
+
+        HD constexpr void reset(int bit) {
+            data[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+        }
+
+        // call f(bit) for every set bit in increasing order, a word is consumed with tzcnt and
+        // a clear of its lowest bit, so the cost follows the popcount and not the width
+        template <typename F>
+        HD constexpr void forEachSetBit(F f, int words = N) const {
+            for (int i = 0; i < words; ++i) {
+                for (uint64_t w = data[i]; w; w &= w - 1)
+                    f((i << 6) + std::countr_zero(w));
+            }
+        }
+
+        constexpr uint64_t popCount() const {
+            return popCount(N);
+        }
+
+        // the operations below only read the first `words` words, the caller knows the higher ones are zero
+        // (see wordsFor), so a wide build on a small IC does not touch the unused part of the mask
+
+        constexpr uint64_t popCount(int words) const {
             uint64_t pc{};
-            for (size_t i = 0; i < N; i++)
+            for (int i = 0; i < words; i++)
                 pc += std::popcount(data[i]);
             return pc;
         }
 
+        HD constexpr bool any(int words) const {
+            for (int i = 0; i < words; ++i)
+                if (data[i]) return true;
+            return false;
+        }
+
+        HD constexpr bool equals(const bitmask& other, int words) const {
+            for (int i = 0; i < words; ++i)
+                if (data[i] != other.data[i]) return false;
+            return true;
+        }
+
+        // (*this & other) == *this
+        HD constexpr bool isSubsetOf(const bitmask& other, int words) const {
+            for (int i = 0; i < words; ++i)
+                if (data[i] & ~other.data[i]) return false;
+            return true;
+        }
+
+        // (*this & other) != 0
+        HD constexpr bool intersects(const bitmask& other, int words) const {
+            for (int i = 0; i < words; ++i)
+                if (data[i] & other.data[i]) return true;
+            return false;
+        }
+
+        HD constexpr bitmask& orAssign(const bitmask& other, int words) {
+            for (int i = 0; i < words; ++i)
+                data[i] |= other.data[i];
+            return *this;
+        }
+
+        HD constexpr bitmask& andAssign(const bitmask& other, int words) {
+            for (int i = 0; i < words; ++i)
+                data[i] &= other.data[i];
+            return *this;
+        }
+
+        HD constexpr bitmask& andNotAssign(const bitmask& other, int words) {
+            for (int i = 0; i < words; ++i)
+                data[i] &= ~other.data[i];
+            return *this;
+        }
+
         void print() const {
             printf("from high to low:");
             for (int i = N - 1; i >= 0; --i) {
@@ -417,18 +514,36 @@ namespace rei
         }
 
     private:
+        HD static constexpr uint64_t fmix(uint64_t x) {
+            x ^= x >> 33;
+            x *= UINT64_C(0xff51afd7ed558ccd);
+            x ^= x >> 33;
+            x *= UINT64_C(0xc4ceb9fe1a85ec53);
+            x ^= x >> 33;
+            return x;
+        }
+
         uint64_t data[N];
     };
 }
 
+namespace rei {
+    static_assert(std::is_trivially_copyable_v<bitmask<2>> && std::is_trivially_copyable_v<bitmask<64>>);
+}
+
 namespace std {
     template <int N>
     struct hash<rei::bitmask<N>> {
-        HD std::size_t operator()(const rei::bitmask<N>& s) const {
-            auto [high, low] = s.get128Hash();
-            std::size_t h1 = std::hash<uint64_t>{}(low);
-            std::size_t h2 = std::hash<uint64_t>{}(high);
-            return h1 ^ (h2 << 1);
+        HD constexpr std::size_t operator()(const rei::bitmask<N>& s) const {
+            return static_cast<std::size_t>(s.fingerprint().low);
+        }
+    };
+
+    template <>
+    struct hash<rei::Fingerprint> {
+        HD constexpr std::size_t operator()(const rei::Fingerprint& f) const {
+            // the halves are already mixed, the low one is enough to pick a slot
+            return static_cast<std::size_t>(f.low);
         }
     };
 }
@@ -1,9 +1,9 @@
 #ifndef BOTTOM_UP_HPP
 #define BOTTOM_UP_HPP
 
-#include <span>
-
 #include <rei_common.hpp>
+#include <search_arena.hpp>
+#include <checkpoint.hpp>
 
 namespace rei {
     class BottomUpSearchResult
@@ -19,48 +19,106 @@ namespace rei {
         class Context
         {
         public:
-            Context(int cache_capacity, const CS& posBits, const CS& negBits);
-
-            ~Context();
-
-            bool InsertAndCheck(CS CS, int index);
+            Context(int cache_capacity, const CS& posBits, const CS& negBits, int words, SearchArena& arena);
 
-            bool InsertAndCheck(CS CS, int lIndex, int rIndex);
+            // every positive and no negative, only the words of the IC are compared
+            bool IsSolution(const CS& cs) const {
+                return posBits.isSubsetOf(cs, words) && !cs.intersects(negBits, words);
+            }
 
-            std::span<CS> GetCacheSlice(int start, int end);
+            bool InsertAndCheck(CS CS, Provenance provenance);
 
-            int* leftRightIdx;
+            Provenance* provenance;
             unsigned long allREs;
+            unsigned long rejected; // languages dropped because they were already visited
+            unsigned long goalChecks;
             int lastIdx; // Index of the last free position in the language cache
             bool onTheFly;
             int cache_capacity;
+            int words;
 
-            CS* cache;
-            std::unordered_map<CS, int> visited;
-            const CS& posBits, negBits;
+            HybridCache& cache;
+            LanguageTable& visited;
+            FrozenLanguageIndex& frozen;
+            const CS& posBits;
+            const CS& negBits;
         };
 
     public:
-        BottomUpSearch(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity);
+        BottomUpSearch(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena);
 
         EnumerationState EnumerateCostLevel(BottomUpSearchResult& res);
 
         std::string ConstructRE(const CS& cs) const;
 
-        std::span<CS> GetLastCostLevel() const;
+        HybridCache::Range GetLastCostLevel() const;
 
-    private:
-        // Adding parentheses if needed
-        std::string bracket(std::string s) const;
+        // every stored language except the alphabets, in cost order
+        HybridCache::Range GetStored() const;
+
+        // the level that is enumerated by the next call, after dropping a level that stopped at a solution
+        int ResumeLevel() const;
+
+        // the levels below this one hold a language for every RE of their cost, so they stay
+        // exact when the IC grows
+        int ExactLevel() const;
+
+        // true once the cache is full and the languages are only checked on the fly
+        bool Overflowed() const;
+
+        // the number of REs enumerated so far
+        unsigned long AllREs() const;
+
+        // the number of languages in the cache, the alphabets included
+        int Stored() const;
+
+        // the fill of the table that tells the stored languages apart, of the frozen index once frozen
+        double VisitedLoad() const;
+
+        // the counters of every level enumerated by this search, a found level included
+        const std::vector<LevelStats>& Stats() const;
 
-        // Generating the final RE string recursively
+        // drop the stored levels from the given one upward, the next call enumerates it again
+        void Rewind(int level);
+
+        // move the stored languages to the current (grown) guide table. newIndex maps every old bit to its
+        // new position and newWords are the indices of the infixes that were added, in increasing order
+        void Remap(const std::vector<int>& newIndex, const std::vector<int>& newWords);
+
+        // index the stored languages in a read-only perfect hash and release the visited table, for when only
+        // ConstructRE and Frozen are used from now on. enumerating again rebuilds the visited table
+        void Freeze();
+
+        // the stored languages after Freeze, the alphabets included
+        const FrozenLanguageIndex& Frozen() const;
+
+        // look for a stored language that satisfies the examples, used after posBits or negBits changed
+        bool FindStored(BottomUpSearchResult& res) const;
+
+        // write the stored levels, Load continues the enumeration from the saved level
+        void Save(CheckpointWriter& writer) const;
+        bool Load(CheckpointReader& reader);
+
+    private:
+        // write the RE of a stored language, the operands are visited with a stack and written into one string
         std::string constructDownward(int index) const;
 
         EnumerationState enumerateLevel(int& idx);
 
+        // the running totals that the operation timers of a level take apart
+        OperationStats counters() const;
+
+        // fill the visited table from the stored languages
+        void rebuildVisited();
+
+        void thaw();
+
         int costLevel;
         int shortageCost;
+        int firstRejectedLevel;
         bool lastRound;
+        bool lastFound;
+        bool isFrozen;
         const unsigned short maxCost;
 
         const CS& posBits;
@@ -68,6 +126,9 @@ namespace rei {
         const Costs& costs;
         const rei::GuideTable& guideTable;
         const std::set<char>& alphabet;
+        std::string letters;    // the alphabet by cache index
+        const SearchArena& arena;
+        std::vector<LevelStats> levelStats;
 
         Context context;
         LevelPartitioner partitioner;
@@ -0,0 +1,95 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+#include <rei.hpp>
+
+namespace rei {
+
+    class BottomUpSearch;
+    class TopDownSearch;
+
+    /// <summary>
+    /// writes the raw arrays of a search to a temporary file, Commit() moves it over the previous checkpoint
+    /// so a preempted run always leaves a complete file behind
+    /// </summary>
+    class CheckpointWriter {
+    public:
+        CheckpointWriter(const std::string& path);
+
+        template <typename T>
+        void Write(const T& value) { WriteArray(&value, 1); }
+
+        template <typename T>
+        void WriteArray(const T* data, size_t count) {
+            out.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+        }
+
+        bool Commit();
+
+    private:
+        std::string path;
+        std::string tmpPath;
+        std::ofstream out;
+    };
+
+    class CheckpointReader {
+    public:
+        CheckpointReader(const std::string& path);
+
+        bool IsOpen() const { return in.is_open(); }
+
+        // false once a read went past the end of the file
+        bool Good() const { return !in.fail(); }
+
+        template <typename T>
+        bool Read(T& value) { return ReadArray(&value, 1); }
+
+        template <typename T>
+        bool ReadArray(T* data, size_t count) {
+            in.read(reinterpret_cast<char*>(data), sizeof(T) * count);
+            return Good();
+        }
+
+    private:
+        std::ifstream in;
+    };
+
+    enum class CheckpointPhase : uint32_t { None = 0, BottomUp = 1, TopDown = 2 };
+
+    /// <summary>
+    /// saves and restores the state of a bidirectional run. the file starts with a fingerprint of the
+    /// examples, the costs and the limits, so a checkpoint of another job is never resumed
+    /// </summary>
+    class Checkpoint {
+    public:
+        Checkpoint(const CheckpointConfigs& configs, uint64_t fingerprint);
+
+        // true when the interval since the last write has passed
+        bool Due() const;
+
+        // topDown is null while the bottom-up levels are still being enumerated
+        bool Save(const BottomUpSearch& bottomUp, const TopDownSearch* topDown);
+
+        // restore the searches from the file, return the phase the run was in or None
+        CheckpointPhase Load(BottomUpSearch& bottomUp, TopDownSearch& topDown);
+
+        // called after the run is finished
+        void Remove();
+
+    private:
+        CheckpointConfigs configs;
+        uint64_t fingerprint;
+        std::chrono::steady_clock::time_point lastSave;
+    };
+
+    uint64_t checkpointFingerprint(const unsigned short* costFun, unsigned short maxCost, int buCacheCapacity, int tdCacheCapacity,
+        const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+}
+
+#endif // CHECKPOINT_HPP
@@ -3,30 +3,121 @@
 
 #include <vector>
 #include <random>
+#include <cstdint>
 #include <types.h>
 
+#if defined(__BMI2__) || defined(__AVX2__)
+#include <immintrin.h>
+#define REI_HAS_PDEP 1
+#endif
+
 namespace rei {
 
     inline std::vector<int> getBits(const CS& cs, int ICsize) {
         std::vector<int> bits;
-        for (int i = 0; i < ICsize; ++i) {
-            if (cs & (CS::one() << i)) {
-                bits.push_back(i);
-            }
-        }
+        bits.reserve(cs.popCount(CS::wordsFor(ICsize)));
+        cs.forEachSetBit([&bits](int i) { bits.push_back(i); }, CS::wordsFor(ICsize));
         return bits;
     }
 
-    inline CS getRandom(const std::vector<int>& bits, std::mt19937_64& rng, std::bernoulli_distribution& coin) {
-        CS submask;
-        for (size_t i = 0; i < bits.size(); ++i) {
-            if (coin(rng)) {
-                submask |= CS::one() << bits[i];
+    // the words of the first `count` bits
+    inline CS firstBits(int count) {
+        CS cs;
+        for (int i = 0; i < count; i++) cs.set(i);
+        return cs;
+    }
+
+    // place the low bits of src on the set bits of mask, lowest first (PDEP)
+    inline uint64_t depositBits(uint64_t src, uint64_t mask) {
+#ifdef REI_HAS_PDEP
+        return _pdep_u64(src, mask);
+#else
+        // branchless, the bits of a counter are close to random
+        uint64_t res = 0;
+        for (; src && mask; src >>= 1, mask &= mask - 1)
+            res |= mask & (~mask + 1) & (0 - (src & 1));
+        return res;
+#endif
+    }
+
+    /// <summary>
+    /// the subsets of the set bits of a CS. a subset is counted in a compact uint64_t, bit j of the counter
+    /// stands for the j-th set bit of the CS, and is expanded one word at a time with PDEP. Next and Previous
+    /// step the expanded subset in the same counter order touching only the words of the set, so a walk
+    /// from Full() down visits the submasks in the same order as cs-- & cs, without the N word arithmetic
+    /// </summary>
+    class SubsetEnumerator {
+    public:
+
+        SubsetEnumerator(const CS& positions, int words = CS::Words) {
+            count = 0;
+            for (int i = 0; i < words; i++) {
+                uint64_t mask = positions.word(i);
+                if (!mask) continue;
+                parts[numParts++] = { i, count, mask };
+                count += std::popcount(mask);
+                // the counter only reaches the words of its first 64 positions
+                if (count >= 64 && !expandParts) expandParts = numParts;
             }
+            if (count < 64) expandParts = numParts;
         }
-        return submask;
-    }
+
+        // the number of positions
+        int Count() const { return count; }
+
+        // the counter of the whole set, Expand only takes counters of at most 64 positions
+        uint64_t Full() const { return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1; }
+
+        CS Expand(uint64_t subset, const CS& base = CS()) const {
+            CS cs = base;
+            for (int i = 0; i < expandParts; i++)
+                cs.orWord(parts[i].word, depositBits(subset >> parts[i].offset, parts[i].mask));
+            return cs;
+        }
+
+        // move an expanded subset to the next or the previous counter, the bits of cs outside the positions are kept.
+        // a carry or a borrow only crosses the words of the set, so a step is O(1) on average
+        void Next(CS& cs) const {
+            for (int i = 0; i < numParts; i++) {
+                const auto& part = parts[i];
+                uint64_t word = cs.word(part.word);
+                uint64_t next = ((word | ~part.mask) + 1) & part.mask;
+                cs.setWord(part.word, (word & ~part.mask) | next);
+                if (next) return;
+            }
+        }
+
+        void Previous(CS& cs) const {
+            for (int i = 0; i < numParts; i++) {
+                const auto& part = parts[i];
+                uint64_t word = cs.word(part.word);
+                uint64_t previous = ((word & part.mask) - 1) & part.mask;
+                cs.setWord(part.word, (word & ~part.mask) | previous);
+                if (word & part.mask) return;
+            }
+        }
+
+        // every position is taken with probability 1/2, one random word per word of the set and any size
+        CS Random(std::mt19937_64& rng, const CS& base = CS()) const {
+            CS cs = base;
+            for (int i = 0; i < numParts; i++)
+                cs.orWord(parts[i].word, rng() & parts[i].mask);
+            return cs;
+        }
+
+    private:
+        struct Part {
+            int word;
+            int offset;
+            uint64_t mask;
+        };
+
+        Part parts[CS::Words];
+        int numParts = 0;
+        int expandParts = 0;
+        int count;
+    };
 
 }
 
-#endif // CS_UTILS
\ No newline at end of file
+#endif // CS_UTILS
@@ -0,0 +1,156 @@
+#ifndef FROZEN_INDEX_H
+#define FROZEN_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <types.h>
+#include <hybrid_cache.h>
+
+namespace rei {
+
+    /// <summary>
+    /// a read-only map from the languages of a hybrid cache to their index, built once the cache stops growing.
+    /// a perfect hash (hash and displace) sends every language to its own slot, so the index takes a pilot per
+    /// bucket of about two languages and one int per slot, with one slot in a hundred left free, and a lookup is
+    /// two hashes and a comparison with the cache. the languages themselves are not copied, the cache has to outlive the index
+    /// </summary>
+    class FrozenLanguageIndex {
+    public:
+
+        void Build(const HybridCache& languages) {
+            cache = &languages;
+            int count = languages.Size();
+
+            buckets = std::max(1, count / bucketSize);
+            pilots.assign(buckets, 0);
+            // a few free slots keep the last buckets from searching long for a pilot
+            slots.assign(static_cast<size_t>(count / loadFactor) + 1, -1);
+
+            struct Key {
+                uint64_t hash;
+                int index;
+            };
+            std::vector<uint32_t> bucketOf(count);
+            std::vector<uint64_t> hashes(count);
+            std::vector<int> offsets(buckets + 1, 0);
+            for (int i = 0; i < count; i++) {
+                auto fingerprint = languages.Get(i).fingerprint();
+                bucketOf[i] = static_cast<uint32_t>(reduce(mix(fingerprint.low), buckets));
+                hashes[i] = fingerprint.high;
+                offsets[bucketOf[i] + 1]++;
+            }
+            for (size_t b = 0; b < buckets; b++) offsets[b + 1] += offsets[b];
+
+            // counting sort by bucket, the languages of a bucket stay in index order
+            std::vector<Key> keys(count);
+            {
+                std::vector<int> next(offsets.begin(), offsets.end() - 1);
+                for (int i = 0; i < count; i++) keys[next[bucketOf[i]]++] = { hashes[i], i };
+            }
+            bucketOf = std::vector<uint32_t>();
+            hashes = std::vector<uint64_t>();
+
+            // two languages with the same fingerprint can not be told apart by any pilot, only the first is indexed
+            std::vector<int> sizes(buckets);
+            int largest = 0;
+            for (size_t b = 0; b < buckets; b++) {
+                int kept = 0;
+                for (int k = offsets[b]; k < offsets[b + 1]; k++) {
+                    bool duplicate = false;
+                    for (int j = offsets[b]; j < offsets[b] + kept && !duplicate; j++) duplicate = keys[j].hash == keys[k].hash;
+                    if (!duplicate) keys[offsets[b] + kept++] = keys[k];
+                }
+                sizes[b] = kept;
+                largest = std::max(largest, kept);
+            }
+
+            // the largest buckets are placed first, while most slots are still free
+            std::vector<int> bySize(largest + 2, 0);
+            for (size_t b = 0; b < buckets; b++) bySize[largest - sizes[b] + 1]++;
+            for (int s = 0; s <= largest; s++) bySize[s + 1] += bySize[s];
+            std::vector<uint32_t> order(buckets);
+            for (size_t b = 0; b < buckets; b++) order[bySize[largest - sizes[b]]++] = static_cast<uint32_t>(b);
+
+            std::vector<size_t> positions;
+            for (auto b : order) {
+                int start = offsets[b], end = start + sizes[b];
+                if (start == end) break;
+                for (uint32_t pilot = 0; ; pilot++) {
+                    auto seed = mix(pilot + UINT64_C(0x9e3779b97f4a7c15));
+                    positions.clear();
+                    bool placed = true;
+                    for (int k = start; k < end && placed; k++) {
+                        size_t position = slotOf(keys[k].hash, seed);
+                        placed = slots[position] < 0 && std::find(positions.begin(), positions.end(), position) == positions.end();
+                        positions.push_back(position);
+                    }
+                    if (!placed) continue;
+
+                    pilots[b] = pilot;
+                    for (int k = start; k < end; k++) slots[positions[k - start]] = keys[k].index;
+                    break;
+                }
+            }
+            size = count;
+        }
+
+        // the index of the language, or -1 when it is not in the cache
+        int Find(const CS& cs) const {
+            if (slots.empty()) return -1;
+            auto fingerprint = cs.fingerprint();
+            auto bucket = reduce(mix(fingerprint.low), buckets);
+            int index = slots[slotOf(fingerprint.high, mix(pilots[bucket] + UINT64_C(0x9e3779b97f4a7c15)))];
+            return index >= 0 && cache->Get(index) == cs ? index : -1;
+        }
+
+        bool Contains(const CS& cs) const { return Find(cs) >= 0; }
+
+        int Size() const { return size; }
+
+        double LoadFactor() const { return slots.empty() ? 0 : static_cast<double>(size) / slots.size(); }
+
+        void Clear() {
+            cache = nullptr;
+            size = 0;
+            pilots.clear();
+            slots.clear();
+        }
+
+        size_t Bytes() const {
+            return pilots.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(int);
+        }
+
+    private:
+        static constexpr int bucketSize = 2;
+        static constexpr double loadFactor = 0.99;
+
+        static uint64_t mix(uint64_t x) {
+            x ^= x >> 33;
+            x *= UINT64_C(0xff51afd7ed558ccd);
+            x ^= x >> 33;
+            x *= UINT64_C(0xc4ceb9fe1a85ec53);
+            x ^= x >> 33;
+            return x;
+        }
+
+        // map a hash to [0, range) with a multiplication instead of a division, the ranges fit in 32 bits
+        static size_t reduce(uint64_t hash, size_t range) {
+            return static_cast<size_t>(((hash >> 32) * range) >> 32);
+        }
+
+        // the seed is the mixed pilot of the bucket
+        size_t slotOf(uint64_t hash, uint64_t seed) const {
+            return reduce(mix(hash ^ seed), slots.size());
+        }
+
+        const HybridCache* cache = nullptr;
+        int size = 0;
+        size_t buckets = 0;
+        std::vector<uint32_t> pilots;
+        std::vector<int> slots;
+    };
+}
+
+#endif // FROZEN_INDEX_H
@@ -2,58 +2,111 @@
 #define GUIDE_TABLE_H
 
 #include <set>
+#include <span>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <type_traits>
 #include <types.h>
 
 namespace rei
 {
+    class CheckpointWriter;
+    class CheckpointReader;
+
+    /// <summary>
+    /// the index of an IC word, 16 bits are enough as long as a CS has at most 65536 bits
+    /// </summary>
+    using GuideIndex = std::conditional_t<sizeof(CS) * 8 <= 65536, uint16_t, int>;
+
     class GuideTable {
     public:
 
-        class Iterator {
-        public:
-            Iterator(const int* p);
+        // word = IC[left] + IC[right]
+        struct Split {
+            GuideIndex left;
+            GuideIndex right;
+        };
 
-            Pair<int> operator*() const;
-            Iterator& operator++();
-            bool operator!=(const Iterator& solved) const;
-        private:
-            const int* ptr;
+        // IC[left] + IC[right] = IC[result], for a fixed left
+        struct Adjacent {
+            GuideIndex right;
+            GuideIndex result;
         };
 
-        class RowIterator {
-        public:
-            RowIterator(const int* data, int gtColumns, int rowIndex);
-            Iterator begin();
-            Iterator end();
-        private:
-            const int* data;
-            int row;
-            int gtColumns;
+        // IC[left] + IC[right] = IC[result], for a fixed right
+        struct Preceding {
+            GuideIndex left;
+            GuideIndex result;
         };
 
-        RowIterator IterateRow(int rowIndex) const;
+        // the splits of a word into two non-empty infixes, by the length of the left part
+        std::span<const Split> IterateRow(int rowIndex) const {
+            return std::span<const Split>(splits.data() + rowStart[rowIndex], rowStart[rowIndex + 1] - rowStart[rowIndex]);
+        }
+
+        // every word that has IC[left] as its left part, including the splits with eps
+        std::span<const Adjacent> IterateAdjacency(int left) const {
+            return std::span<const Adjacent>(adjacent.data() + adjacentStart[left], adjacentStart[left + 1] - adjacentStart[left]);
+        }
 
-        GuideTable(std::vector<std::vector<int>> gt, int alphabetSize);
+        // every word that has IC[right] as its right part, including the splits with eps. both adjacencies are
+        // sorted by the other part, since the words with a fixed left or right part are in the shortlex order of the other
+        std::span<const Preceding> IterateReverseAdjacency(int right) const {
+            return std::span<const Preceding>(preceding.data() + precedingStart[right], precedingStart[right + 1] - precedingStart[right]);
+        }
+
+        // rowStart has ICsize + 1 entries, the splits of word i are splits[rowStart[i], rowStart[i + 1])
+        GuideTable(std::vector<int> rowStart, std::vector<Split> splits, int alphabetSize);
 
         GuideTable();
 
-        ~GuideTable();
+        GuideTable(const GuideTable&) = delete;
+        GuideTable& operator=(const GuideTable&) = delete;
+
+        GuideTable(GuideTable&&) noexcept = default;
+        GuideTable& operator=(GuideTable&&) noexcept = default;
+
+        // the rows are written as they are, the adjacency is rebuilt when loading
+        void Save(CheckpointWriter& writer) const;
+        bool Load(CheckpointReader& reader);
+
+        // the words of a CS that can hold a bit of this IC, the rest are always zero
+        int Words() const { return CS::wordsFor(ICsize); }
 
         int ICsize;
-        int gtColumns;
         int alphabetSize;
-        // adjacencyList[i][j].first : i the index of the first bit while .first is the index
-        // of the second bit and .second is the result of concatenation
-        std::vector<std::vector<std::pair<int, int>>> adjacencyList;
+
     private:
-        int* data;
+        void buildAdjacency();
+
+        // both views are stored in compressed sparse rows
+        std::vector<int> rowStart;
+        std::vector<Split> splits;
+
+        std::vector<int> adjacentStart;
+        std::vector<Adjacent> adjacent;
+
+        std::vector<int> precedingStart;
+        std::vector<Preceding> preceding;
     };
 
     bool generatingGuideTable(GuideTable& guideTable, CS& posBits, CS& negBits,
         const std::vector<std::string>& pos, const std::vector<std::string>& neg);
 
+    // the infix closure of the examples in shortlex order, the index of a word is its bit in CS.
+    // no word can be dropped: an infix x of an example a x b is the left part of the split x|b of the
+    // suffix xb, which is the right part of the split a|xb of the example, so the bit of x decides
+    // the bit of an example under concatenation and the search needs it to tell the languages apart
+    std::vector<std::string> generatingIC(const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+
+    // same as above, for an IC that was already generated
+    bool generatingGuideTable(GuideTable& guideTable, CS& posBits, CS& negBits, const std::vector<std::string>& ic,
+        const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+
+    // return the index of the word in the IC, or -1
+    int indexOfWord(const std::vector<std::string>& ic, const std::string& word);
+
 }
 
 #endif // end GUIDE_TABLE_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef GUIDE_TABLE_CACHE_HPP
+#define GUIDE_TABLE_CACHE_HPP
+
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <types.h>
+#include <guide_table.hpp>
+
+namespace rei {
+
+    /// <summary>
+    /// keeps the guide tables of solved example sets in a directory, one file per set. the file name is a hash
+    /// of the sorted and deduplicated examples, so the same set in any order skips the IC construction
+    /// </summary>
+    class GuideTableCache {
+    public:
+        GuideTableCache(const std::string& directory);
+
+        // load the table of the examples or generate and store it, false when the IC does not fit in a CS
+        bool Get(GuideTable& guideTable, CS& posBits, CS& negBits, std::set<char>& alphabets,
+            const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+
+        uint64_t Hits() const { return hits; }
+        uint64_t Misses() const { return misses; }
+
+        // the generated tables that could not be written to the directory
+        uint64_t FailedStores() const { return failedStores; }
+
+    private:
+        bool load(const std::string& path, uint64_t key, const std::vector<std::string>& pos, const std::vector<std::string>& neg,
+            GuideTable& guideTable, CS& posBits, CS& negBits, std::set<char>& alphabets);
+
+        bool store(const std::string& path, uint64_t key, const std::vector<std::string>& pos, const std::vector<std::string>& neg,
+            const GuideTable& guideTable, const CS& posBits, const CS& negBits, const std::set<char>& alphabets);
+
+        std::string directory;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t failedStores = 0;
+    };
+
+    // the hash of the examples, independent of their order and of duplicates
+    uint64_t exampleSetKey(const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+}
+
+#endif // GUIDE_TABLE_CACHE_HPP
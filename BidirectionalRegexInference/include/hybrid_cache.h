@@ -0,0 +1,171 @@
+#ifndef HYBRID_CACHE_H
+#define HYBRID_CACHE_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <types.h>
+#include <guide_table.hpp>
+
+namespace rei {
+
+    /// <summary>
+    /// a stored language, either the sorted indices of its words (sparse) or the first words of its bitmask (dense).
+    /// it points into the cache, so it is only valid until the next language is pushed
+    /// </summary>
+    class HybridView {
+    public:
+
+        bool Sparse() const { return bits == nullptr; }
+
+        // sparse only
+        const GuideIndex* begin() const { return indices; }
+        const GuideIndex* end() const { return indices + count; }
+        int Count() const { return count; }
+
+        // dense only
+        const uint64_t* Bits() const { return bits; }
+
+        bool test(int bit) const {
+            if (bits) return (bits[bit >> 6] >> (bit & 63)) & 1;
+            return std::binary_search(begin(), end(), static_cast<GuideIndex>(bit));
+        }
+
+        void orInto(CS& cs) const {
+            if (bits) {
+                for (int i = 0; i < words; i++) cs.orWord(i, bits[i]);
+            }
+            else {
+                for (auto i : *this) cs.set(i);
+            }
+        }
+
+        CS ToCS() const {
+            CS cs;
+            orInto(cs);
+            return cs;
+        }
+
+        const GuideIndex* indices = nullptr;
+        const uint64_t* bits = nullptr;
+        int count = 0;
+        int words = 0;
+    };
+
+    /// <summary>
+    /// the languages of the bottom-up search in index order. a language with few words keeps only their indices,
+    /// the rest keep the words of the IC and not the whole CS, so the early levels take a few bytes per language
+    /// and the operations on them only look at their words (see processConcatenate on views)
+    /// </summary>
+    class HybridCache {
+    public:
+
+        // drop every language, the dense ones take the given number of words from now on
+        void Reset(int words) {
+            this->words = words;
+            entries.clear();
+            indices.clear();
+            bits.clear();
+        }
+
+        void Reserve(size_t count) { entries.reserve(count); }
+
+        int Size() const { return static_cast<int>(entries.size()); }
+        int Words() const { return words; }
+
+        // a list of n words takes n + 1 indices, it is kept while it is not larger than the dense words
+        int SparseLimit() const {
+            return static_cast<int>(words * sizeof(uint64_t) / sizeof(GuideIndex)) - 1;
+        }
+
+        void Push(const CS& cs) {
+            auto count = static_cast<int>(cs.popCount(words));
+            if (count <= SparseLimit()) {
+                entries.push_back(indices.size());
+                indices.push_back(static_cast<GuideIndex>(count));
+                cs.forEachSetBit([this](int i) { indices.push_back(static_cast<GuideIndex>(i)); }, words);
+            }
+            else {
+                entries.push_back(denseFlag | bits.size());
+                for (int i = 0; i < words; i++) bits.push_back(cs.word(i));
+            }
+        }
+
+        HybridView View(int i) const {
+            HybridView view;
+            view.words = words;
+            auto entry = entries[i];
+            if (entry & denseFlag) {
+                view.bits = bits.data() + (entry & ~denseFlag);
+            }
+            else {
+                view.count = indices[entry];
+                view.indices = indices.data() + entry + 1;
+            }
+            return view;
+        }
+
+        CS Get(int i) const { return View(i).ToCS(); }
+
+        // keep the first size languages
+        void Truncate(int size) {
+            size_t indicesEnd = 0, bitsEnd = 0;
+            for (int i = size - 1; i >= 0 && (!indicesEnd || !bitsEnd); i--) {
+                auto entry = entries[i];
+                if (entry & denseFlag) { if (!bitsEnd) bitsEnd = (entry & ~denseFlag) + words; }
+                else if (!indicesEnd) indicesEnd = entry + 1 + indices[entry];
+            }
+            entries.resize(size);
+            indices.resize(indicesEnd);
+            bits.resize(bitsEnd);
+        }
+
+        void Swap(HybridCache& other) {
+            std::swap(words, other.words);
+            entries.swap(other.entries);
+            indices.swap(other.indices);
+            bits.swap(other.bits);
+        }
+
+        size_t Bytes() const {
+            return entries.capacity() * sizeof(uint64_t) + indices.capacity() * sizeof(GuideIndex) + bits.capacity() * sizeof(uint64_t);
+        }
+
+        // the languages [start, end) as CS values
+        class Range {
+        public:
+            class Iterator {
+            public:
+                CS operator*() const { return cache->Get(i); }
+                Iterator& operator++() { i++; return *this; }
+                bool operator==(const Iterator& other) const { return i == other.i; }
+                bool operator!=(const Iterator& other) const { return i != other.i; }
+
+                const HybridCache* cache;
+                int i;
+            };
+
+            Iterator begin() const { return { cache, start }; }
+            Iterator end() const { return { cache, finish }; }
+            size_t size() const { return finish - start; }
+
+            const HybridCache* cache;
+            int start;
+            int finish;
+        };
+
+        Range Slice(int start, int end) const { return { this, start, end }; }
+
+    private:
+        // an entry is the offset of the language in indices, or in bits when the flag is set
+        static constexpr uint64_t denseFlag = uint64_t(1) << 63;
+
+        int words = 0;
+        std::vector<uint64_t> entries;
+        std::vector<GuideIndex> indices;
+        std::vector<uint64_t> bits;
+    };
+}
+
+#endif // HYBRID_CACHE_H
@@ -0,0 +1,153 @@
+#ifndef INDEX_TABLE_H
+#define INDEX_TABLE_H
+
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+
+namespace rei {
+
+    /// <summary>
+    /// open addressing map from a key to an int index. every slot is stamped with the epoch it was
+    /// written in, so Clear() only bumps the epoch and the table keeps its memory between runs
+    /// </summary>
+    template <typename Key>
+    class IndexTable {
+    public:
+
+        // return the stored index or nullptr
+        int* Find(const Key& key) {
+            if (!slots) return nullptr;
+            lookups++;
+            for (size_t i = slotOf(key); ; i = (i + 1) & mask) {
+                probes++;
+                auto& slot = slots[i];
+                if (slot.epoch != epoch) return nullptr;
+                if (slot.key == key) return &slot.value;
+            }
+        }
+
+        const int* Find(const Key& key) const {
+            return const_cast<IndexTable*>(this)->Find(key);
+        }
+
+        bool Contains(const Key& key) const { return Find(key) != nullptr; }
+
+        int At(const Key& key) const {
+            auto value = Find(key);
+            if (!value) throw std::out_of_range("IndexTable::At");
+            return *value;
+        }
+
+        // insert the key if it is not there, .second is false when the key was already stored
+        std::pair<int*, bool> Insert(const Key& key, int value) {
+            if ((count + 1) * 2 > capacity()) grow();
+            lookups++;
+            for (size_t i = slotOf(key); ; i = (i + 1) & mask) {
+                probes++;
+                auto& slot = slots[i];
+                if (slot.epoch != epoch) {
+                    slot.key = key;
+                    slot.value = value;
+                    slot.epoch = epoch;
+                    count++;
+                    return { &slot.value, true };
+                }
+                if (slot.key == key) return { &slot.value, false };
+            }
+        }
+
+        int& operator[](const Key& key) {
+            return *Insert(key, 0).first;
+        }
+
+        void Clear() {
+            count = 0;
+            if (++epoch == 0) {
+                // the stamps wrapped around, old slots could look alive again
+                for (size_t i = 0; i < capacity(); i++) slots[i].epoch = 0;
+                epoch = 1;
+            }
+        }
+
+        // drop the slots and their memory, the table grows again from the first insert
+        void Release() {
+            slots.reset();
+            mask = 0;
+            count = 0;
+            epoch = 1;
+        }
+
+        size_t Size() const { return count; }
+
+        // the fraction of the slots in use
+        double LoadFactor() const { return capacity() ? static_cast<double>(count) / capacity() : 0; }
+
+        // call f(key, value) for every stored key
+        template <typename F>
+        void ForEach(F f) const {
+            for (size_t i = 0; i < capacity(); i++)
+                if (slots[i].epoch == epoch) f(slots[i].key, slots[i].value);
+        }
+
+        // number of bytes held by the table
+        size_t Bytes() const { return capacity() * sizeof(Slot); }
+
+        // the finds and inserts since the table was made and the slots they read, the rehash of a grow is not counted
+        uint64_t Lookups() const { return lookups; }
+        uint64_t Probes() const { return probes; }
+
+    private:
+
+        struct Slot {
+            Key key;
+            int value;
+            uint32_t epoch;
+        };
+
+        static uint64_t mix(uint64_t x) {
+            x ^= x >> 33;
+            x *= UINT64_C(0xff51afd7ed558ccd);
+            x ^= x >> 33;
+            x *= UINT64_C(0xc4ceb9fe1a85ec53);
+            x ^= x >> 33;
+            return x;
+        }
+
+        size_t slotOf(const Key& key) const {
+            return mix(std::hash<Key>{}(key)) & mask;
+        }
+
+        size_t capacity() const { return slots ? mask + 1 : 0; }
+
+        void grow() {
+            size_t oldCapacity = capacity();
+            size_t newCapacity = oldCapacity ? oldCapacity * 2 : 1024;
+
+            std::unique_ptr<Slot[]> old = std::move(slots);
+            uint32_t oldEpoch = epoch;
+
+            slots.reset(new Slot[newCapacity]);
+            for (size_t i = 0; i < newCapacity; i++) slots[i].epoch = 0;
+            mask = newCapacity - 1;
+            epoch = 1;
+            count = 0;
+
+            uint64_t oldLookups = lookups, oldProbes = probes;
+            for (size_t i = 0; i < oldCapacity; i++)
+                if (old[i].epoch == oldEpoch) Insert(old[i].key, old[i].value);
+            lookups = oldLookups;
+            probes = oldProbes;
+        }
+
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        size_t count = 0;
+        uint32_t epoch = 1;
+        uint64_t lookups = 0;
+        uint64_t probes = 0;
+    };
+}
+
+#endif // INDEX_TABLE_H
@@ -0,0 +1,177 @@
+#ifndef LANGUAGE_TABLE_H
+#define LANGUAGE_TABLE_H
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include <types.h>
+#include <rei.hpp>
+#include <index_table.h>
+#include <checkpoint.hpp>
+
+namespace rei {
+
+    /// <summary>
+    /// the visited map of a search, from a language to its index. in the exact mode the whole CS is the key,
+    /// in the fingerprint mode only its 128 bit fingerprint is stored and two languages with the same fingerprint
+    /// are taken as one. one in 64 fingerprints also keeps its full CS, every lookup that hits one of them
+    /// is checked against it so the collision rate of the run can be measured
+    /// </summary>
+    class LanguageTable {
+    public:
+
+        void SetMode(DedupeMode newMode) {
+            if (newMode == mode) return;
+            mode = newMode;
+            Clear();
+        }
+
+        DedupeMode Mode() const { return mode; }
+
+        int* Find(const CS& cs) {
+            if (mode == DedupeMode::Exact) return exact.Find(cs);
+
+            auto fingerprint = cs.fingerprint();
+            auto value = approx.Find(fingerprint);
+            if (value) verify(fingerprint, cs);
+            return value;
+        }
+
+        const int* Find(const CS& cs) const {
+            return const_cast<LanguageTable*>(this)->Find(cs);
+        }
+
+        bool Contains(const CS& cs) const { return Find(cs) != nullptr; }
+
+        int At(const CS& cs) const {
+            auto value = Find(cs);
+            if (!value) throw std::out_of_range("LanguageTable::At");
+            return *value;
+        }
+
+        std::pair<int*, bool> Insert(const CS& cs, int value) {
+            if (mode == DedupeMode::Exact) return exact.Insert(cs, value);
+
+            auto fingerprint = cs.fingerprint();
+            auto res = approx.Insert(fingerprint, value);
+            if (!res.second) verify(fingerprint, cs);
+            else if (isSampled(fingerprint)) {
+                sampled.Insert(fingerprint, static_cast<int>(samples.size()));
+                samples.push_back(cs);
+            }
+            return res;
+        }
+
+        int& operator[](const CS& cs) {
+            return *Insert(cs, 0).first;
+        }
+
+        void Clear() {
+            exact.Clear();
+            approx.Clear();
+            sampled.Clear();
+            samples.clear();
+            stats = DedupeStats();
+        }
+
+        // drop every language and give the memory back, the stats of the run are kept
+        void Release() {
+            exact.Release();
+            approx.Release();
+            sampled.Release();
+            samples = std::vector<CS>();
+        }
+
+        size_t Size() const {
+            return mode == DedupeMode::Exact ? exact.Size() : approx.Size();
+        }
+
+        double LoadFactor() const {
+            return mode == DedupeMode::Exact ? exact.LoadFactor() : approx.LoadFactor();
+        }
+
+        size_t Bytes() const {
+            return exact.Bytes() + approx.Bytes() + sampled.Bytes() + samples.capacity() * sizeof(CS);
+        }
+
+        DedupeStats Stats() const { return stats; }
+
+        // the lookups of the table in use and their probes, the sampled CSs are not counted
+        uint64_t Lookups() const { return exact.Lookups() + approx.Lookups(); }
+        uint64_t Probes() const { return exact.Probes() + approx.Probes(); }
+
+        // the keys are written as they are stored, a table of the other mode can not be loaded
+        void Save(CheckpointWriter& writer) const {
+            writer.Write(mode);
+            writer.Write(static_cast<uint64_t>(Size()));
+            if (mode == DedupeMode::Exact)
+                exact.ForEach([&writer](const CS& cs, int value) { writer.Write(cs); writer.Write(value); });
+            else
+                approx.ForEach([&writer](const Fingerprint& fingerprint, int value) { writer.Write(fingerprint); writer.Write(value); });
+        }
+
+        // the entries are returned in `loaded` and only put in this table by Swap, so a failed read changes nothing
+        bool Load(CheckpointReader& reader, LanguageTable& loaded) const {
+            DedupeMode fileMode;
+            uint64_t count;
+            if (!reader.Read(fileMode) || fileMode != mode || !reader.Read(count)) return false;
+
+            loaded.SetMode(mode);
+            loaded.Clear();
+            for (uint64_t i = 0; i < count; i++) {
+                int value;
+                if (mode == DedupeMode::Exact) {
+                    CS cs;
+                    reader.Read(cs);
+                    if (!reader.Read(value)) return false;
+                    loaded.exact.Insert(cs, value);
+                }
+                else {
+                    Fingerprint fingerprint;
+                    reader.Read(fingerprint);
+                    if (!reader.Read(value)) return false;
+                    loaded.approx.Insert(fingerprint, value);
+                }
+            }
+            return true;
+        }
+
+        // call f(value) for every stored language
+        template <typename F>
+        void ForEachValue(F f) const {
+            exact.ForEach([&f](const CS&, int value) { f(value); });
+            approx.ForEach([&f](const Fingerprint&, int value) { f(value); });
+        }
+
+        void Swap(LanguageTable& other) {
+            std::swap(*this, other);
+        }
+
+    private:
+
+        static bool isSampled(const Fingerprint& fingerprint) {
+            return (fingerprint.high >> 58) == 0;
+        }
+
+        void verify(const Fingerprint& fingerprint, const CS& cs) {
+            if (!isSampled(fingerprint)) return;
+            auto index = sampled.Find(fingerprint);
+            if (!index) return;
+            stats.sampledHits++;
+            if (!(samples[*index] == cs)) stats.collisions++;
+        }
+
+        DedupeMode mode = DedupeMode::Exact;
+
+        IndexTable<CS> exact;
+        IndexTable<Fingerprint> approx;
+
+        IndexTable<Fingerprint> sampled;
+        std::vector<CS> samples;
+
+        DedupeStats stats;
+    };
+}
+
+#endif // LANGUAGE_TABLE_H
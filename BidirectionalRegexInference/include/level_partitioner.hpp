@@ -2,10 +2,14 @@
 #define LEVEL_PARTITIONER_H
 
 #include <tuple>
+#include <vector>
 #include <operations.h>
 
 namespace rei {
 
+    class CheckpointWriter;
+    class CheckpointReader;
+
     class LevelPartitioner {
     public:
 
@@ -22,10 +26,18 @@ namespace rei {
 
         void indexToLevel(int index, int& level, Operation& op) const;
 
+        void Save(CheckpointWriter& writer) const;
+
+        // read the points of a file into `points` and check them against the lastIdx of the same file, every
+        // point is an index up to lastIdx or INT_MAX for a level that stopped at a solution. Assign takes them
+        bool Load(CheckpointReader& reader, std::vector<int>& points, int lastIdx) const;
+        void Assign(const std::vector<int>& points);
+
     private:
 
         int* startPoints;
         int opCount;
+        int size;
     };
 }
 
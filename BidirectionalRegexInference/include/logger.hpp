@@ -0,0 +1,113 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <new>
+#include <type_traits>
+
+// the records kept by the build, set by the LOG_LEVEL option of CMake
+#define REI_LOG_OFF 0
+#define REI_LOG_INFO 1
+#define REI_LOG_DEBUG 2
+
+#ifndef REI_LOG_LEVEL
+#define REI_LOG_LEVEL REI_LOG_OFF
+#endif
+
+// the arguments are not evaluated when the level is compiled out
+#if REI_LOG_LEVEL >= REI_LOG_INFO
+#define LOG_INFO(...) rei::Logger::Instance().Write(__VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if REI_LOG_LEVEL >= REI_LOG_DEBUG
+#define LOG_DEBUG(...) rei::Logger::Instance().Write(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+// wait for the records written so far, before output that should follow them
+#if REI_LOG_LEVEL >= REI_LOG_INFO
+#define LOG_FLUSH() rei::Logger::Instance().Flush()
+#else
+#define LOG_FLUSH() ((void)0)
+#endif
+
+namespace rei {
+
+    /// <summary>
+    /// a bounded lock-free ring of log records shared by every thread. a record keeps the printf format and a copy
+    /// of its arguments, a background thread formats the records and writes them to stderr, so a search only pays
+    /// for a few stores. a record that finds the ring full is dropped and counted, the writer never waits
+    /// </summary>
+    class Logger {
+    public:
+
+        static Logger& Instance();
+
+        ~Logger();
+
+        // the format has to outlive the record, a string literal. the arguments are copied as they are
+        template <typename... Args>
+        void Write(const char* format, Args... args) {
+            using Payload = std::tuple<const char*, Args...>;
+            static_assert((std::is_trivially_copyable_v<Args> && ...), "log arguments are copied into the ring");
+            static_assert(sizeof(Payload) <= payloadSize && alignof(Payload) <= alignof(std::max_align_t), "too many log arguments");
+
+            auto record = acquire();
+            if (!record) return;
+            new (record->payload) Payload(format, args...);
+            record->print = &print<Args...>;
+            publish(record);
+        }
+
+        // wait until the background thread wrote every record published so far
+        void Flush();
+
+        // the records that found the ring full
+        uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t capacity = 4096;
+        static constexpr size_t payloadSize = 128;
+
+        struct Record {
+            std::atomic<uint64_t> sequence;
+            void (*print)(const Record&, FILE*);
+            alignas(std::max_align_t) unsigned char payload[payloadSize];
+        };
+
+        template <typename... Args>
+        static void print(const Record& record, FILE* out) {
+            const auto& payload = *std::launder(reinterpret_cast<const std::tuple<const char*, Args...>*>(record.payload));
+            std::apply([out](const char* format, auto... args) { std::fprintf(out, format, args...); }, payload);
+        }
+
+        Logger();
+
+        // claim the next free record, or nullptr when the ring is full
+        Record* acquire();
+        void publish(Record* record);
+
+        // write the published records, return false when there was none
+        bool drain();
+
+        void run();
+
+        std::unique_ptr<Record[]> ring;
+        alignas(64) std::atomic<uint64_t> tail = 0;
+        alignas(64) std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<bool> stopping = false;
+        std::thread writer;
+    };
+}
+
+#endif // LOGGER_HPP
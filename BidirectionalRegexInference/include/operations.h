@@ -8,9 +8,10 @@
 #include <utility>
 #include <functional>
 #include <guide_table.hpp>
+#include <hybrid_cache.h>
+#include <algorithm>
 
-template<typename T>
-using vector = std::vector<T>;
+using std::vector;
 
 namespace rei
 {
@@ -18,6 +19,9 @@ namespace rei
 
     std::string to_string(Operation op);
 
+    // the one letter name of an operation, a literal that a log record can keep
+    const char* shortName(Operation op);
+
     inline CS processQuestion(const CS& cs) {
         return cs | CS::one();
     }
@@ -25,17 +29,14 @@ namespace rei
     inline CS processStar(const GuideTable& guideTable, const CS& cs) {
 
         auto res = cs | CS::one();
-        int ix = guideTable.alphabetSize + 1;
-        CS c = CS::one() << ix;
 
-        while (ix < guideTable.ICsize)
+        for (int ix = guideTable.alphabetSize + 1; ix < guideTable.ICsize; ix++)
         {
-            if (!(res & c)) {
+            if (!res.test(ix)) {
                 for (auto [left, right] : guideTable.IterateRow(ix)) {
-                    if (((CS::one() << left) & res) && ((CS::one() << right) & res)) { res |= c; break; }
+                    if (res.test(left) && res.test(right)) { res.set(ix); break; }
                 }
             }
-            c <<= 1; ix++;
         }
 
         return res;
@@ -44,21 +45,16 @@ namespace rei
     inline CS processConcatenate(const GuideTable& guideTable, const CS& left, const CS& right) {
 
         CS cs1 = CS();
-        if (left & CS::one()) cs1 |= right;
-        if (right & CS::one()) cs1 |= left;
-
-        int ix = guideTable.alphabetSize + 1;
-        CS c = CS::one() << ix;
+        if (left.test(0)) cs1.orAssign(right, guideTable.Words());
+        if (right.test(0)) cs1.orAssign(left, guideTable.Words());
 
-        while (ix < guideTable.ICsize)
+        for (int ix = guideTable.alphabetSize + 1; ix < guideTable.ICsize; ix++)
         {
             // when CS have value that means one of parts contains phi, check above
-            if (!(cs1 & c)) {
+            if (!cs1.test(ix)) {
                 for (auto [l, r] : guideTable.IterateRow(ix))
-                    if (((CS::one() << l) & left) && ((CS::one() << r) & right)) { cs1 |= c; break; }
+                    if (left.test(l) && right.test(r)) { cs1.set(ix); break; }
             }
-
-            c <<= 1; ix++;
         }
 
         return cs1;
@@ -68,6 +64,71 @@ namespace rei
         return left | right;
     }
 
+    // the same operations on the languages of the bottom-up cache. a sparse operand only visits the words
+    // that start or end with one of its words instead of every split of the IC
+
+    inline CS processQuestion(const HybridView& view) {
+        CS cs = view.ToCS();
+        cs.set(0);
+        return cs;
+    }
+
+    inline CS processStar(const GuideTable& guideTable, const HybridView& view) {
+        return processStar(guideTable, view.ToCS());
+    }
+
+    inline CS processOr(const HybridView& left, const HybridView& right) {
+        CS cs = left.ToCS();
+        right.orInto(cs);
+        return cs;
+    }
+
+    inline CS processConcatenate(const GuideTable& guideTable, const HybridView& left, const HybridView& right) {
+
+        CS cs = CS();
+
+        // the adjacency of a word is sorted by the other part, so two lists are merged
+        auto merge = [&cs](auto adjacency, const HybridView& other, auto otherPart) {
+            auto it = adjacency.begin();
+            for (auto i : other) {
+                it = std::lower_bound(it, adjacency.end(), i, [&](const auto& a, GuideIndex i) { return otherPart(a) < i; });
+                if (it == adjacency.end()) break;
+                if (otherPart(*it) == i) cs.set(it->result);
+            }
+        };
+
+        if (left.Sparse() && (!right.Sparse() || left.Count() <= right.Count())) {
+            auto rightPart = [](const GuideTable::Adjacent& a) { return a.right; };
+            for (auto l : left) {
+                auto adjacency = guideTable.IterateAdjacency(l);
+                if (right.Sparse()) merge(adjacency, right, rightPart);
+                else for (auto [r, result] : adjacency) if (right.test(r)) cs.set(result);
+            }
+        }
+        else if (right.Sparse()) {
+            auto leftPart = [](const GuideTable::Preceding& a) { return a.left; };
+            for (auto r : right) {
+                auto adjacency = guideTable.IterateReverseAdjacency(r);
+                if (left.Sparse()) merge(adjacency, left, leftPart);
+                else for (auto [l, result] : adjacency) if (left.test(l)) cs.set(result);
+            }
+        }
+        else {
+            if (left.test(0)) right.orInto(cs);
+            if (right.test(0)) left.orInto(cs);
+
+            for (int ix = guideTable.alphabetSize + 1; ix < guideTable.ICsize; ix++)
+            {
+                if (!cs.test(ix)) {
+                    for (auto [l, r] : guideTable.IterateRow(ix))
+                        if (left.test(l) && right.test(r)) { cs.set(ix); break; }
+                }
+            }
+        }
+
+        return cs;
+    }
+
     std::vector<CS> revertQuestion(const CS& cs);
 
     std::vector<CS> revertStarRandom(const CS& cs, size_t maxSamples, const GuideTable& guideTable, uint64_t seed = std::random_device{}());
@@ -17,30 +17,11 @@ namespace rei {
             : left(left), right(right) {
         }
 
-        HD Pair(const Pair& other)
-            : left(other.left), right(other.right) {
-        }
-
-        HD Pair(Pair&& other) noexcept
-            : left(std::move(other.left)),
-            right(std::move(other.right)) {
-        }
-
-        HD Pair& operator=(const Pair& other) {
-            if (this != &other) {
-                left = other.left;
-                right = other.right;
-            }
-            return *this;
-        }
-
-        HD Pair& operator=(Pair&& other) noexcept {
-            if (this != &other) {
-                left = std::move(other.left);
-                right = std::move(other.right);
-            }
-            return *this;
-        }
+        // defaulted, so a pair of trivially copyable halves is trivially copyable too
+        HD Pair(const Pair& other) = default;
+        HD Pair(Pair&& other) noexcept = default;
+        HD Pair& operator=(const Pair& other) = default;
+        HD Pair& operator=(Pair&& other) noexcept = default;
 
         HD inline bool operator==(const Pair& other) const {
             return left == other.left && right == other.right;
@@ -0,0 +1,45 @@
+#ifndef PROVENANCE_H
+#define PROVENANCE_H
+
+#include <cstdint>
+#include <operations.h>
+
+namespace rei {
+
+    /// <summary>
+    /// how a stored bottom-up language was built: its operation and the cache indices of its operands, packed in
+    /// one word so the operation is read with the operands instead of being searched in the level partition.
+    /// the op takes the top 2 bits and each operand 31 bits, the right operand of a unary op is unused
+    /// </summary>
+    class Provenance {
+    public:
+        // the left operand of eps + r
+        static constexpr int Eps = -2;
+
+        Provenance() = default;
+
+        Provenance(Operation op, int left, int right = 0) :
+            bits(static_cast<uint64_t>(op) << 62 | encode(left) << 31 | encode(right)) {
+        }
+
+        Operation Op() const { return static_cast<Operation>(bits >> 62); }
+        int Left() const { return decode(bits >> 31); }
+        int Right() const { return decode(bits); }
+
+    private:
+        static constexpr uint64_t operandMask = (uint64_t(1) << 31) - 1;
+
+        // eps is stored as the largest operand, no cache gets that large
+        static uint64_t encode(int operand) { return static_cast<uint64_t>(operand) & operandMask; }
+        static int decode(uint64_t field) {
+            int operand = static_cast<int>(field & operandMask);
+            return operand == static_cast<int>(operandMask & static_cast<uint64_t>(Eps)) ? Eps : operand;
+        }
+
+        uint64_t bits = 0;
+    };
+
+    static_assert(sizeof(Provenance) == sizeof(uint64_t));
+}
+
+#endif // PROVENANCE_H
@@ -2,79 +2,186 @@
 #define REGEX_MATCH_HPP
 
 #include <string>
-#include <memory>
 #include <stdexcept>
 #include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <string_view>
 
 using std::string;
-using std::shared_ptr;
-using std::make_shared;
 using std::runtime_error;
 using std::vector;
 
-class Regex {
-public:
-    virtual bool match(const string& word) const = 0;
-    virtual ~Regex() = default;
-};
+enum class RegexTag : uint8_t { Char, Or, And, Concat, Star, Optional };
 
-class Char : public Regex {
-public:
-    char c;
-     Char(char c);
-     bool match(const string& word) const override;
+// a node of a parsed pattern, the operands are indices in the node array of the tree
+struct RegexNode {
+    RegexTag tag;
+    char c;         // Char
+    int left;       // the operand of Star and Optional
+    int right;
 };
 
-class Or : public Regex {
+/// <summary>
+/// a parsed pattern with every node in one array. the operands of a node are stored before it, so every
+/// subpattern is a contiguous range that ends at its root and a loop over the array visits the operands first.
+/// a tree without nodes is eps
+/// </summary>
+class RegexTree {
 public:
-    shared_ptr<Regex> left, right;
-     Or(shared_ptr<Regex> l, shared_ptr<Regex> r);
-     bool match(const string& word) const override;
-};
+    const RegexNode& operator[](int i) const { return nodes[i]; }
 
-class And : public Regex {
-public:
-    shared_ptr<Regex> left, right;
-     And(shared_ptr<Regex> l, shared_ptr<Regex> r);
-     bool match(const string& word) const override;
-};
+    int Size() const { return static_cast<int>(nodes.size()); }
 
-class Star : public Regex {
-public:
-    shared_ptr<Regex> node;
-     Star(shared_ptr<Regex> n);
-     bool match(const string& word) const override;
-};
+    // the root is the last node, or -1 for eps
+    int Root() const { return Size() - 1; }
 
-class Optional : public Regex {
-public:
-    shared_ptr<Regex> node;
-     Optional(shared_ptr<Regex> n);
-     bool match(const string& word) const override;
-};
+    int Add(RegexTag tag, int left = -1, int right = -1, char c = 0) {
+        nodes.push_back({ tag, c, left, right });
+        return Size() - 1;
+    }
 
-class Concat : public Regex {
-public:
-    shared_ptr<Regex> left, right;
-     Concat(shared_ptr<Regex> l, shared_ptr<Regex> r);
-     bool match(const string& word) const override;
+    void Reserve(size_t size) { nodes.reserve(size); }
+
+    // try every split of the word, only for the patterns that can not be compiled
+    bool Backtrack(int node, std::string_view word) const;
+
+private:
+    vector<RegexNode> nodes;
 };
 
 class Parser {
     string regex;
     size_t pos;
+    RegexTree tree;
 
      char peek();
      char get();
-     shared_ptr<Regex> parseOr();
-     shared_ptr<Regex> parseIntersection();
-     shared_ptr<Regex> parseConcat();
-     shared_ptr<Regex> parseFactor();
-     shared_ptr<Regex> parseBase();
+     int parseOr();
+     int parseIntersection();
+     int parseConcat();
+     int parseFactor();
+     int parseBase();
 
 public:
      Parser(const string& s);
-     shared_ptr<Regex> parse();
+     RegexTree parse();
+};
+
+/// <summary>
+/// the words of a batch in a trie, so a prefix that many words share is matched once for all of them. the nodes
+/// are in depth-first order, a node comes after its parent and its subtree is the range of nodes up to end
+/// </summary>
+class ExampleTrie {
+public:
+    struct Node {
+        int parent;     // -1 for the root, which is the empty word
+        int end;
+        char letter;
+    };
+
+    ExampleTrie(const vector<string>& words);
+
+    const Node& operator[](int i) const { return nodes[i]; }
+    int Size() const { return static_cast<int>(nodes.size()); }
+
+    // the node of the i-th word
+    int NodeOf(int word) const { return nodeOf[word]; }
+    int Words() const { return static_cast<int>(nodeOf.size()); }
+
+private:
+    vector<Node> nodes;
+    vector<int> nodeOf;
+};
+
+/// <summary>
+/// a pattern compiled to its Glushkov automaton, one state per letter of the pattern, and determinized lazily.
+/// a DFA state is a set of Glushkov states, it is built the first time a word reaches it and its transitions are
+/// kept in a flat table by letter class, so a warm matcher takes one lookup per letter. when the states pass
+/// the memory cap the DFA is dropped and built again from the current state.
+/// '&' is compiled at the top of the pattern as one automaton per operand, a pattern with a nested '&' is
+/// matched by the tree. the DFA is built while matching, so a matcher is not shared between threads, a copy is
+/// </summary>
+class RegexMatcher {
+public:
+    static constexpr size_t DefaultDfaBytes = size_t(64) << 20;
+
+    RegexMatcher(const string& pattern, size_t dfaBytes = DefaultDfaBytes);
+
+    bool Match(const string& word) const;
+
+    // the result of every word of the trie, the automaton walks the trie edges instead of the words.
+    // a large trie is split in ranges of nodes between threads
+    vector<bool> Match(const ExampleTrie& trie) const;
+
+    // the DFA states that are built, and the times they were dropped for the cap
+    size_t States() const;
+    size_t Flushes() const;
+
+private:
+    class Automaton {
+    public:
+        // the automaton of the subpattern at root, -1 for eps
+        Automaton(const RegexTree& tree, int root, size_t dfaBytes);
+
+        bool Match(const string& word) const;
+
+        // whether the nodes [begin, end) of the trie are accepted, accepted[0] is the node begin
+        void Match(const ExampleTrie& trie, int begin, int end, char* accepted) const;
+
+        size_t States() const { return accepting.size(); }
+        size_t Flushes() const { return flushes; }
+
+    private:
+        struct Node {
+            bool nullable;
+            vector<uint64_t> first;
+            vector<uint64_t> last;
+        };
+
+        static constexpr int Dead = 0;
+        static constexpr int Start = 1;
+
+        Node build(const RegexTree& tree, int node);
+        uint64_t* follow(int position) { return follows.data() + position * words; }
+        const uint64_t* follow(int position) const { return follows.data() + position * words; }
+
+        // the DFA state after a letter of the class, the transition is stored unless the DFA had to be dropped
+        int step(int state, int letterClass) const;
+        int next(int state, char letter) const {
+            int letterClass = classOf[static_cast<unsigned char>(letter)];
+            int to = transitions[static_cast<size_t>(state) * classes + letterClass];
+            return to < 0 ? step(state, letterClass) : to;
+        }
+        int intern(const uint64_t* set) const;
+        void reset() const;
+
+        // the sets have one more bit than the positions, it marks the start state
+        int words;
+        int positions = 0;
+        bool nullable;
+        vector<uint64_t> first;
+        vector<uint64_t> last;
+        vector<uint64_t> follows;   // positions x words
+        vector<uint64_t> letters;   // 256 x words, the positions of every letter
+
+        // class 0 is every letter that is not in the pattern
+        int classes;
+        unsigned char classOf[256];
+        vector<unsigned char> classLetter;
+
+        size_t dfaBytes;
+        mutable vector<uint64_t> sets;      // states x words
+        mutable vector<int> transitions;    // states x classes, -1 until it is built
+        mutable vector<char> accepting;
+        mutable std::unordered_map<string, int> index;
+        mutable vector<uint64_t> scratch;
+        mutable size_t flushes = 0;
+    };
+
+    vector<Automaton> conjuncts;
+    RegexTree fallback;
+    bool backtrack = false;
 };
 
  /// <summary>
@@ -83,7 +190,8 @@ public:
  bool match(const string& pattern, const string& word);
 
  /// <summary>
-/// return true if the whole word match the regex pattern, but work for batch
+/// return true if the whole word match the regex pattern, but work for batch. the words are matched
+/// through their trie
 /// </summary>
  vector<bool> match(const vector<string>& examples, const string& pattern);
 
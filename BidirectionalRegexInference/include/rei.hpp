@@ -3,22 +3,265 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <functional>
 
 namespace rei {
 
+    class SearchArena;
+    class GuideTableCache;
+
+    /// <summary>
+    /// how the searches tell the languages they already stored apart
+    /// </summary>
+    enum class DedupeMode : uint32_t
+    {
+        // the whole CS is the key of the visited tables
+        Exact = 0,
+        // only a 128 bit fingerprint is kept, two languages with the same fingerprint are merged
+        Fingerprint = 1,
+    };
+
+    /// <summary>
+    /// the lookups of the fingerprint mode that were checked against a full CS, and how many of them
+    /// matched a different language
+    /// </summary>
+    struct DedupeStats
+    {
+        uint64_t sampledHits = 0;
+        uint64_t collisions = 0;
+
+        double CollisionRate() const { return sampledHits ? static_cast<double>(collisions) / sampledHits : 0; }
+
+        DedupeStats& operator+=(const DedupeStats& other) {
+            sampledHits += other.sampledHits;
+            collisions += other.collisions;
+            return *this;
+        }
+    };
+
+    /// <summary>
+    /// the counters of one operation of a search level. every search is driven by a single thread and keeps its own
+    /// counters, so they are plain integers that stay on in production
+    /// </summary>
+    struct OperationStats
+    {
+        uint64_t        candidates = 0;         // the languages the operation produced
+        uint64_t        duplicates = 0;         // candidates dropped because the search already had them
+        uint64_t        goalChecks = 0;         // candidates tested against the examples, top-down the solved pairs
+        uint64_t        inversions = 0;         // top-down parents that were inverted
+        uint64_t        cappedInversions = 0;   // the inversions that reached the sample limit
+        uint64_t        inverted = 0;           // the results of the inversions after sampling, a pair counts once
+        uint64_t        lookups = 0;            // visited table lookups
+        uint64_t        probes = 0;             // the slots they read, probes / lookups is the mean probe length
+        double          time = 0;               // seconds
+
+        OperationStats& operator+=(const OperationStats& other) {
+            candidates += other.candidates;
+            duplicates += other.duplicates;
+            goalChecks += other.goalChecks;
+            inversions += other.inversions;
+            cappedInversions += other.cappedInversions;
+            inverted += other.inverted;
+            lookups += other.lookups;
+            probes += other.probes;
+            time += other.time;
+            return *this;
+        }
+
+        OperationStats operator-(const OperationStats& other) const {
+            OperationStats res;
+            res.candidates = candidates - other.candidates;
+            res.duplicates = duplicates - other.duplicates;
+            res.goalChecks = goalChecks - other.goalChecks;
+            res.inversions = inversions - other.inversions;
+            res.cappedInversions = cappedInversions - other.cappedInversions;
+            res.inverted = inverted - other.inverted;
+            res.lookups = lookups - other.lookups;
+            res.probes = probes - other.probes;
+            res.time = time - other.time;
+            return res;
+        }
+    };
+
+    /// <summary>
+    /// one enumerated level of a search, the operations are ?, *, concatenation and + in this order
+    /// </summary>
+    struct LevelStats
+    {
+        int             level = 0;      // the cost of a bottom-up level, the depth of a top-down one
+        double          time = 0;       // seconds, the RE construction of a found level included
+        size_t          arenaBytes = 0; // the size of the arena when the level ended
+        OperationStats  operations[4];
+
+        OperationStats Total() const {
+            OperationStats total;
+            for (const auto& op : operations) total += op;
+            return total;
+        }
+    };
+
+    /// <summary>
+    /// the levels of both searches in the order they were enumerated. a restored checkpoint starts them empty
+    /// </summary>
+    struct SearchStats
+    {
+        std::vector<LevelStats> bottomUp;
+        std::vector<LevelStats> topDown;
+
+        static OperationStats Total(const std::vector<LevelStats>& levels) {
+            OperationStats total;
+            for (const auto& level : levels) total += level.Total();
+            return total;
+        }
+    };
+
     struct Result
     {
         std::string     RE;
         int             ICsize;
         uint64_t        allCS;
+        DedupeStats     dedupe;
+        SearchStats     stats;
 
         Result(const std::string& RE, int ICsize, uint64_t allCS)
             : RE(RE), ICsize(ICsize), allCS(allCS) {
         }
     };
 
+    /// <summary>
+    /// the progress of a solve, reported when a phase ends: the guide table, the setup of the searches (a restored
+    /// checkpoint included), every level of the bottom-up search, the freeze of its languages and every level of
+    /// the top-down search. the counters are totals of the search
+    /// </summary>
+    struct PhaseStats
+    {
+        std::string     phase;          // "guide_table", "setup", "bottom_up", "freeze" or "top_down"
+        int             level = 0;      // the cost of a bottom-up level, the depth of a top-down one
+        double          time = 0;       // seconds since the previous report
+        uint64_t        generated = 0;  // the candidates the search produced
+        uint64_t        stored = 0;     // the unique languages it kept, the IC words for the guide table
+        double          load = 0;       // the fill of its visited table
+        size_t          rss = 0;        // resident memory of the process in bytes
+        LevelStats      detail;         // the counters of a bottom-up or top-down level
+    };
+
+    using StatsListener = std::function<void(const PhaseStats&)>;
+
+    /// <summary>
+    /// number of languages each search is allowed to store
+    /// </summary>
+    struct SearchLimits
+    {
+        int buCacheCapacity = DefaultBottomUpCapacity();
+        int tdCacheCapacity = DefaultTopDownCapacity();
+        DedupeMode dedupe = DedupeMode::Exact;
+
+        // 2M and 8M languages, fewer when the CS is so wide that they would not fit in memory
+        static int DefaultBottomUpCapacity();
+        static int DefaultTopDownCapacity();
+
+        // split a memory budget (in bytes) between the bottom-up and the top-down caches
+        static SearchLimits FromMemoryBudget(size_t bytes, DedupeMode dedupe = DedupeMode::Exact);
+    };
+
+    /// <summary>
+    /// where the state of a long run is saved, so it can be resumed after the process was stopped
+    /// </summary>
+    struct CheckpointConfigs
+    {
+        std::string path;
+        // the minimum number of seconds between two writes, the state is only saved at level boundaries
+        double interval = 60;
+    };
+
+    /// <summary>
+    /// the examples that an RE gets wrong. the language of the RE is evaluated on the IC of the examples with the
+    /// same operations as the search, so the check takes a few mask operations instead of matching every example
+    /// </summary>
+    struct Verification
+    {
+        std::vector<std::string> unmatchedPos;
+        std::vector<std::string> matchedNeg;
+
+        bool Passed() const { return unmatchedPos.empty() && matchedNeg.empty(); }
+    };
+
+    Verification Verify(const std::string& RE, const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+
+    // with selfCheck, an RE that does not separate the examples throws a logic_error instead of being returned
 	Result Run(const unsigned short* costFun, const unsigned short maxCost,
-        const std::vector<std::string>& pos, const std::vector<std::string>& neg, double maxTime);
+        const std::vector<std::string>& pos, const std::vector<std::string>& neg, double maxTime, bool selfCheck = false);
+
+    /// <summary>
+    /// keeps the caches, index arrays and hash tables alive between solves. the tables are reset in O(1),
+    /// so calling Solve repeatedly skips the allocation and page-fault cost of a fresh Run
+    /// </summary>
+    class Solver
+    {
+    public:
+        Solver(const unsigned short* costFun, const unsigned short maxCost, const SearchLimits& limits = SearchLimits());
+        ~Solver();
+
+        Solver(const Solver&) = delete;
+        Solver& operator=(const Solver&) = delete;
+
+        Result Solve(const std::vector<std::string>& pos, const std::vector<std::string>& neg);
+
+        // save the search state to configs.path while solving. a matching file left by a stopped run
+        // is resumed, and the file is removed once the run finishes. an empty path turns it off
+        void SetCheckpoint(const CheckpointConfigs& configs);
+
+        // keep the guide tables in a directory, an example set that was seen before skips the IC construction.
+        // an empty directory turns it off
+        void SetGuideTableCache(const std::string& directory);
+
+        // check every found RE against the examples in language space, a wrong one throws a logic_error
+        void SetSelfCheck(bool enabled) { selfCheck = enabled; }
+
+        // call the listener at the end of every phase of a solve, on the solving thread. an empty one turns it off
+        void SetStatsListener(StatsListener listener) { statsListener = std::move(listener); }
+
+        // the memory held between solves in bytes
+        size_t ArenaBytes() const;
+
+    private:
+        unsigned short costFun[5];
+        unsigned short maxCost;
+        SearchLimits limits;
+        CheckpointConfigs checkpoint;
+        bool selfCheck = false;
+        StatsListener statsListener;
+        std::unique_ptr<SearchArena> arena;
+        std::unique_ptr<GuideTableCache> guideTableCache;
+    };
+
+    /// <summary>
+    /// solves an example set that grows one word at a time. when a word is added, the guide table is rebuilt
+    /// from the extended IC, the stored bottom-up languages are moved to the new bit positions, and the cost
+    /// levels that are still exact under the new IC are kept instead of enumerated again
+    /// </summary>
+    class Session
+    {
+    public:
+        Session(const unsigned short* costFun, const unsigned short maxCost, const SearchLimits& limits = SearchLimits());
+        ~Session();
+
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        // return false if the word is already an example of the other side
+        bool AddPositive(const std::string& word);
+        bool AddNegative(const std::string& word);
+
+        Result Solve();
+
+    private:
+        class State;
+        std::unique_ptr<State> state;
+    };
 }
 
-#endif //end REI_HPP
\ No newline at end of file
+#endif //end REI_HPP
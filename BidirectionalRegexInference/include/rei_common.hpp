@@ -38,6 +38,10 @@ namespace rei {
     std::set<char> findAlphabets(const std::vector<std::string>& pos, const std::vector<std::string>& neg);
 
     bool intialCheck(std::set<char> alphabets, const std::vector<std::string>& pos, std::string& RE);
+
+    // the words of the IC that the pattern matches, evaluated with the operations of the search. the IC is closed
+    // under infixes, so every operation is exact on it and the bits of the examples are the result of matching them
+    CS languageOf(const GuideTable& guideTable, const std::set<char>& alphabets, const std::string& pattern);
 }
 
 #endif // REI_COMMON_H
\ No newline at end of file
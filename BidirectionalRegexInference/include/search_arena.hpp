@@ -0,0 +1,60 @@
+#ifndef SEARCH_ARENA_HPP
+#define SEARCH_ARENA_HPP
+
+#include <memory>
+
+#include <types.h>
+#include <rei.hpp>
+#include <language_table.h>
+#include <hybrid_cache.h>
+#include <provenance.h>
+#include <frozen_index.h>
+
+namespace rei {
+
+    /// <summary>
+    /// owns the large buffers and the hash tables of the bottom-up and top-down searches. the buffers only grow,
+    /// so running many jobs through the same arena pays the allocation and page-fault cost once
+    /// </summary>
+    class SearchArena {
+    public:
+
+        // make sure the buffers can hold the given number of languages
+        void Reserve(const SearchLimits& limits);
+
+        HybridCache& BottomUpCache() { return buCache; }
+        Provenance* BottomUpProvenance() const { return buProvenance.get(); }
+        FrozenLanguageIndex& BottomUpFrozen() { return buFrozen; }
+
+        CS* TopDownCache() const { return tdCache.get(); }
+        int* TopDownStatus() const { return tdStatus.get(); }
+        int* TopDownParentIdx() const { return tdParentIdx.get(); }
+
+        // the tables are cleared in O(1) by the search that takes them
+        LanguageTable& BottomUpVisited() { return buVisited; }
+        LanguageTable& TopDownVisited() { return tdVisited; }
+
+        // the collisions seen by the tables since they were last cleared
+        DedupeStats Stats() const;
+
+        // the size of the buffers and the tables in bytes
+        size_t Bytes() const;
+
+    private:
+        int buCapacity = -1;
+        int tdCapacity = -1;
+
+        HybridCache buCache;
+        std::unique_ptr<Provenance[]> buProvenance;
+        FrozenLanguageIndex buFrozen;
+
+        std::unique_ptr<CS[]> tdCache;
+        std::unique_ptr<int[]> tdStatus;
+        std::unique_ptr<int[]> tdParentIdx;
+
+        LanguageTable buVisited;
+        LanguageTable tdVisited;
+    };
+}
+
+#endif // SEARCH_ARENA_HPP
@@ -0,0 +1,59 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <chrono>
+#include <utility>
+
+#include <rei.hpp>
+#include <operations.h>
+
+namespace rei {
+
+    /// <summary>
+    /// charges the work of a level to the operation that runs it. `counters` returns the running totals of the
+    /// search, the timer keeps them at the start of an operation and adds the difference to the level when the
+    /// operation ends, by Next or when the timer goes out of scope on an early return
+    /// </summary>
+    template <typename Counters>
+    class OperationTimer {
+    public:
+
+        OperationTimer(LevelStats& level, Counters counters, Operation op)
+            : level(level), counters(std::move(counters)), current(op) {
+            start();
+        }
+
+        ~OperationTimer() { stop(); }
+
+        OperationTimer(const OperationTimer&) = delete;
+        OperationTimer& operator=(const OperationTimer&) = delete;
+
+        void Next(Operation op) {
+            stop();
+            current = op;
+            start();
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void start() {
+            begin = counters();
+            startTime = Clock::now();
+        }
+
+        void stop() {
+            auto& stats = level.operations[static_cast<int>(current)];
+            stats += counters() - begin;
+            stats.time += std::chrono::duration<double>(Clock::now() - startTime).count();
+        }
+
+        LevelStats& level;
+        Counters counters;
+        Operation current;
+        OperationStats begin;
+        Clock::time_point startTime;
+    };
+}
+
+#endif // SEARCH_STATS_H
@@ -4,16 +4,18 @@
 #include <string>
 #include <vector>
 #include <unordered_set>
-#include <unordered_map>
 #include <span>
 
 #include <rei_common.hpp>
+#include <search_arena.hpp>
+#include <checkpoint.hpp>
 
 namespace rei {
 
 	struct TopDownSearchResult {
 		std::string RE;
         uint64_t allCS;
+        int level;
 	};
 
     struct HeuristicConfigs {
@@ -89,9 +91,7 @@ namespace rei {
 
         public:
 
-            Context(int cache_capacity);
-
-            ~Context();
+            Context(SearchArena& arena);
 
             void AddSolutionSet(const std::vector<CS>& solutionSet);
 
@@ -106,19 +106,43 @@ namespace rei {
 
             int GetLastOutmostParent();
 
+            // the graph of a file, read and checked by Load and only put in the context by Assign
+            struct Loaded {
+                int lastIdx = 0;
+                uint64_t allCS = 0;
+                Counter counter = {};
+                std::vector<CS> cache;
+                std::vector<int> status;
+                std::vector<int> parentIdx;
+                LanguageTable visited;
+            };
+
+            void Save(CheckpointWriter& writer) const;
+            bool Load(CheckpointReader& reader, int cache_capacity, Loaded& loaded) const;
+            void Assign(Loaded& loaded);
+
+            // the language of the original nodes and the given leaves, a redirect holds the empty language
             CS* cache;
             // 0 = the original node, -1 = given, < -1 = redirectIdx, > 1 = leftIdx
             int* status; 
-            std::unordered_map<int, CS> idxToSolved;
             // Index of the last free position in the language cache
             int lastIdx;
             Counter counter;
             uint64_t allCS;
+            uint64_t goalChecks;    // pairs whose children were both solved, the walk up to the root followed
+            // the languages that another search already solved, looked up instead of being pushed
+            const FrozenLanguageIndex* given = nullptr;
+            // from a language to its original node, see insert
+            LanguageTable& visited;
 
         private:
-            NodeType getNodeType(const CS& cs);
+            // the value of a language in the visited table is the index of its original node, or one of these
+            static constexpr int SolutionSet = -1;  // reaching it again closes a cycle
+            static constexpr int Solved = -2;       // pushed or given, it becomes a leaf
+            static constexpr int Dropped = -3;      // added by a pair that closed a cycle, taken as not visited
 
-            void insert(NodeType nodeType, CS cs, int pIdx);
+            // write the node of a child at idx, with a single probe of the visited table
+            NodeType insert(const CS& cs, int pIdx, int idx);
 
             bool isSolved(int idx);
 
@@ -127,21 +151,34 @@ namespace rei {
             int getOutmostParent(int index);
 
             int* parentIdx;
-
-            std::unordered_map<CS, int> visited;
-            std::unordered_set<CS> solved;
         };
 
     public:
 
         TopDownSearch(const GuideTable& guideTable,
-            std::shared_ptr<CSResolverInterface> resolver, int maxLevel, const CS& posBits, const CS& negBits, int cache_capacity);
+            std::shared_ptr<CSResolverInterface> resolver, int maxLevel, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena);
         bool Push(const CS& cs, TopDownSearchResult& res);
 
+        // take every language of the index as solved, the index is shared and has to outlive the search
+        void SetGiven(const FrozenLanguageIndex& given);
+
         EnumerationState EnumerateLevel(TopDownSearchResult& res);
 
         void SetHeuristic(HeuristicConfigs heuristicConfigs);
 
+        // the number of children the inversions produced so far, the dropped ones included
+        uint64_t Candidates() const;
+
+        // the fill of the visited table
+        double VisitedLoad() const;
+
+        // the counters of every level enumerated by this search, a found level included
+        const std::vector<LevelStats>& Stats() const;
+
+        // write the graph at a level boundary, Load continues from the next level
+        void Save(CheckpointWriter& writer) const;
+        bool Load(CheckpointReader& reader);
+
     private:
 
         std::vector<CS> generateSolutionSet();
@@ -154,6 +191,12 @@ namespace rei {
 
         std::string constructDownward(int index);
 
+        // the running totals that the operation timers of a level take apart
+        OperationStats counters() const;
+
+        // count an inversion of a parent, capped when sampling stopped it at the limit
+        void countInversion(size_t results, bool sampled, int maxSamples);
+
         int level = 0;
         int maxLevel;
 
@@ -167,6 +210,12 @@ namespace rei {
         Context context;
 
         HeuristicConfigs heuristicConfigs;
+
+        const SearchArena& arena;
+        std::vector<LevelStats> levelStats;
+        uint64_t inversions = 0;
+        uint64_t cappedInversions = 0;
+        uint64_t inverted = 0;
     };
 }
 
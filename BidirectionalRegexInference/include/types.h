@@ -1,7 +1,10 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <type_traits>
+
 #include <bitmask.h>
+#include <pair.h>
 
 #if CS_BIT_COUNT == 0
 using CS = rei::bitmask<2>;
@@ -13,8 +16,17 @@ using CS = rei::bitmask<8>;
 using CS = rei::bitmask<16>;
 #elif CS_BIT_COUNT == 4
 using CS = rei::bitmask<32>;
-#else
+#elif CS_BIT_COUNT == 5
 using CS = rei::bitmask<64>;
+#elif CS_BIT_COUNT == 6
+using CS = rei::bitmask<128>;
+#elif CS_BIT_COUNT == 7
+using CS = rei::bitmask<256>;
+#else
+using CS = rei::bitmask<512>;
 #endif
 
+// the inversions return vectors of pairs, which are copied and moved as raw words
+static_assert(std::is_trivially_copyable_v<rei::Pair<CS>>);
+
 #endif // end TYPES_H
\ No newline at end of file
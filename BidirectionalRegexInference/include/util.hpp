@@ -5,6 +5,8 @@
 #include <sstream>
 #include <iostream>
 
+#include <rei.hpp>
+
 namespace rei
 {
 	// Reading the input stream
@@ -27,6 +29,19 @@ namespace rei
 
 	// return the number of each operation in the regex pattern
 	OperationsCount countOpreations(const std::string& pattern);
+
+	// return the cost of the regex pattern under the given cost function
+	int calculateCost(const std::string& pattern, const unsigned short* costFun);
+
+	// escape the quotes and backslashes of a string for a JSON value
+	std::string escapeJson(const std::string& s);
+
+	// the resident memory of the process in bytes, 0 where it can not be read
+	size_t residentBytes();
+
+	// the counters as a JSON object, a level keeps its operations by name
+	std::string toJson(const OperationStats& stats);
+	std::string toJson(const LevelStats& stats);
 }
 
 #endif //end UTIL_HPP
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <batch.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include <util.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // compare the names the same way scripts/run_batch.py does, so exp2 comes before exp10
+    bool naturalLess(const std::string& a, const std::string& b) {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (isdigit(a[i]) && isdigit(b[j])) {
+                size_t ei = i, ej = j;
+                while (ei < a.size() && isdigit(a[ei])) ei++;
+                while (ej < b.size() && isdigit(b[ej])) ej++;
+                auto na = std::stoull(a.substr(i, ei - i));
+                auto nb = std::stoull(b.substr(j, ej - j));
+                if (na != nb) return na < nb;
+                i = ei; j = ej;
+            }
+            else {
+                char ca = tolower(a[i]), cb = tolower(b[j]);
+                if (ca != cb) return ca < cb;
+                i++; j++;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+
+    // a CSV field, quoted like the csv module of Python when it holds a separator, a quote or a line break
+    std::string csvField(const std::string& s) {
+        if (s.find_first_of(",\"\r\n") == std::string::npos) return s;
+        std::string res = "\"";
+        for (auto c : s) {
+            if (c == '"') res += '"';
+            res += c;
+        }
+        return res + "\"";
+    }
+}
+
+std::vector<std::string> rei::collectBatchFiles(const std::string& source) {
+
+    std::vector<std::string> files;
+
+    if (fs::is_directory(source)) {
+        for (const auto& entry : fs::directory_iterator(source))
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+                files.push_back(entry.path().string());
+
+        std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+            return naturalLess(fs::path(a).filename().string(), fs::path(b).filename().string());
+            });
+        return files;
+    }
+
+    std::ifstream list(source);
+    if (!list.is_open()) {
+        printf("Unable to open \"%s\"\n", source.c_str());
+        return files;
+    }
+
+    std::string line;
+    while (getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) files.push_back(line);
+    }
+
+    return files;
+}
+
+void rei::RunBatch(const std::vector<std::string>& files, const unsigned short* costFun, const unsigned short maxCost,
+    const BatchConfigs& configs, std::ostream& out) {
+
+    SearchLimits limits = configs.jobMemory ? SearchLimits::FromMemoryBudget(configs.jobMemory, configs.dedupe) : SearchLimits();
+    limits.dedupe = configs.dedupe;
+
+    std::mutex outMutex;
+    std::atomic<size_t> next = 0;
+
+    if (configs.format == BatchFormat::CSV) {
+        out << "File,RE,Cost,REs,Time (s)\n";
+        out.flush();
+    }
+
+    auto worker = [&]() {
+
+        Solver solver(costFun, maxCost, limits);
+        solver.SetGuideTableCache(configs.guideTableCache);
+
+        for (size_t i = next++; i < files.size(); i = next++) {
+
+            std::vector<std::string> pos, neg;
+            if (!readFile(files[i], pos, neg)) {
+                printf("\nSkipping %s\n", files[i].c_str());
+                continue;
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            auto res = solver.Solve(pos, neg);
+            auto stop = std::chrono::high_resolution_clock::now();
+
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
+            double time = (double)duration * 0.000001;
+            int cost = calculateCost(res.RE, costFun);
+            auto name = fs::path(files[i]).stem().string();
+
+            std::lock_guard<std::mutex> lock(outMutex);
+            if (configs.format == BatchFormat::CSV)
+                out << csvField(name) << "," << csvField(res.RE) << "," << cost << "," << res.allCS << "," << time << "\n";
+            else
+                out << "{\"file\":\"" << escapeJson(name) << "\",\"RE\":\"" << escapeJson(res.RE) << "\",\"cost\":" << cost
+                << ",\"REs\":" << res.allCS << ",\"time\":" << time
+                << (configs.dedupe == DedupeMode::Fingerprint ? ",\"sampledHits\":" + std::to_string(res.dedupe.sampledHits)
+                    + ",\"collisions\":" + std::to_string(res.dedupe.collisions) : std::string())
+                << ",\"bottomUp\":" << toJson(SearchStats::Total(res.stats.bottomUp))
+                << ",\"topDown\":" << toJson(SearchStats::Total(res.stats.topDown)) << "}\n";
+            out.flush();
+        }
+    };
+
+    int threads = std::max(1, configs.threads);
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+
+    for (auto& t : pool) t.join();
+}
@@ -1,65 +1,68 @@
 #include <bottom_up.hpp>
 
-#define LOG_OP(context, cost, op_string, dif) \
-        int tbc = dif; \
-        if (tbc) printf("Cost %-2d | (%s) | AllREs: %-11llu | StoredREs: %-10d | ToBeChecked: %-10d \n", \
-            cost, op_string.c_str() ,context.allREs, context.lastIdx, tbc);
+#include <algorithm>
+#include <chrono>
 
-rei::BottomUpSearch::Context::Context(int cache_capacity, const CS& posBits, const CS& negBits) : cache_capacity(cache_capacity), posBits(posBits), negBits(negBits) {
+#include <logger.hpp>
+#include <search_stats.h>
 
-    cache = new CS[cache_capacity + 1];
-    leftRightIdx = new int[2 * (cache_capacity + 1)];
+// a record per operation of a level, only built with LOG_LEVEL=debug
+#if REI_LOG_LEVEL >= REI_LOG_DEBUG
+#define LOG_OP(context, cost, op, dif) \
+        do { if (int tbc = dif) LOG_DEBUG("Cost %-2d | (%s) | AllREs: %-11llu | StoredREs: %-10d | ToBeChecked: %-10d \n", \
+            cost, shortName(op), static_cast<unsigned long long>(context.allREs), context.lastIdx, tbc); } while (0)
+#else
+#define LOG_OP(context, cost, op, dif) ((void)0)
+#endif
+
+rei::BottomUpSearch::Context::Context(int cache_capacity, const CS& posBits, const CS& negBits, int words, SearchArena& arena) : cache_capacity(cache_capacity), words(words), cache(arena.BottomUpCache()), visited(arena.BottomUpVisited()), frozen(arena.BottomUpFrozen()), posBits(posBits), negBits(negBits) {
+
+    cache.Reset(words);
+    visited.Clear();
+    frozen.Clear();
+    provenance = arena.BottomUpProvenance();
 
     lastIdx = 0;
     allREs = 0;
+    rejected = 0;
+    goalChecks = 0;
     onTheFly = false;
 }
 
-rei::BottomUpSearch::Context::~Context() {
-    delete[] cache;
-    delete[] leftRightIdx;
-}
-
-bool rei::BottomUpSearch::Context::InsertAndCheck(CS CS, int index) {
-    return InsertAndCheck(CS, index, -1);
-}
-
-bool rei::BottomUpSearch::Context::InsertAndCheck(CS CS, int lIndex, int rIndex)
+bool rei::BottomUpSearch::Context::InsertAndCheck(CS CS, Provenance from)
 {
     allREs++;
     if (onTheFly) {
-        if ((CS & posBits) == posBits && (~CS & negBits) == negBits) {
-            leftRightIdx[lastIdx << 1] = lIndex;
-            if (rIndex > -1)
-                leftRightIdx[(lastIdx << 1) + 1] = rIndex;
+        goalChecks++;
+        if (IsSolution(CS)) {
+            provenance[lastIdx] = from;
             return true;
         }
     }
-    else if (visited.find(CS) == visited.end())
+    else if (!visited.Contains(CS))
     {
-        leftRightIdx[lastIdx << 1] = lIndex;
-        if (rIndex > -1)
-            leftRightIdx[(lastIdx << 1) + 1] = rIndex;
-        if ((CS & posBits) == posBits && (~CS & negBits) == negBits) {
+        provenance[lastIdx] = from;
+        goalChecks++;
+        if (IsSolution(CS)) {
             return true;
         }
-        visited[CS] = lastIdx;
-        cache[lastIdx++] = CS;
+        visited[CS] = lastIdx++;
+        cache.Push(CS);
         if (lastIdx == cache_capacity) onTheFly = true;
     }
+    else rejected++;
     return false;
 }
 
-std::span<CS> rei::BottomUpSearch::Context::GetCacheSlice(int start, int end) {
-    return std::span<CS>(cache + start, end - start);
-}
-
-rei::BottomUpSearch::BottomUpSearch(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity) :
-    guideTable(guideTable), alphabet(alphabets), costs(costs), maxCost(maxCost), posBits(posBits), negBits(negBits), context(cache_capacity, posBits, negBits), partitioner(maxCost + 1) {
+rei::BottomUpSearch::BottomUpSearch(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena) :
+    maxCost(maxCost), posBits(posBits), negBits(negBits), costs(costs), guideTable(guideTable), alphabet(alphabets), letters(alphabets.begin(), alphabets.end()), arena(arena), context(cache_capacity, posBits, negBits, guideTable.Words(), arena), partitioner(maxCost + 1) {
 
     costLevel = costs.alpha + 1;
     shortageCost = -1;
+    firstRejectedLevel = INT_MAX;
     lastRound = false;
+    lastFound = false;
+    isFrozen = false;
 
     // adding eps, empty and alphabets
     context.visited[CS()] = -1;
@@ -67,8 +70,8 @@ rei::BottomUpSearch::BottomUpSearch(const GuideTable& guideTable, const std::set
     for (int i = 0; i < static_cast<int>(alphabets.size()); i++)
     {
         auto alpha = CS::one() << (i + 1);
-        context.visited[alpha] = context.lastIdx;
-        context.cache[context.lastIdx++] = alpha;
+        context.visited[alpha] = context.lastIdx++;
+        context.cache.Push(alpha);
     }
 
     partitioner.end(costs.alpha, Operation::Concatenate) = context.lastIdx;
@@ -78,13 +81,27 @@ rei::BottomUpSearch::BottomUpSearch(const GuideTable& guideTable, const std::set
 rei::EnumerationState rei::BottomUpSearch::EnumerateCostLevel(BottomUpSearchResult& res) {
 
     if (costLevel > maxCost) return EnumerationState::End;
+    thaw();
+
+    auto startTime = std::chrono::steady_clock::now();
+    levelStats.emplace_back();
+    levelStats.back().level = costLevel;
 
     int solvedIdx;
+    auto rejected = context.rejected;
     EnumerationState enumState = enumerateLevel(solvedIdx);
 
+    if (context.rejected != rejected && firstRejectedLevel > costLevel)
+        firstRejectedLevel = costLevel;
+    lastFound = enumState == EnumerationState::Found;
+
     if (enumState == EnumerationState::Found)
         res.RE = constructDownward(solvedIdx);
 
+    auto& stats = levelStats.back();
+    stats.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    stats.arenaBytes = arena.Bytes();
+
     res.cost = costLevel;
     res.allREs = context.allREs;
 
@@ -94,60 +111,324 @@ rei::EnumerationState rei::BottomUpSearch::EnumerateCostLevel(BottomUpSearchResu
 }
 
 std::string rei::BottomUpSearch::ConstructRE(const CS& cs) const {
-    auto idx = context.visited.at(cs);
+    if (isFrozen) {
+        if (cs == CS::one()) return std::string("eps");
+        auto idx = context.frozen.Find(cs);
+        if (idx < 0) throw std::out_of_range("BottomUpSearch::ConstructRE");
+        return constructDownward(idx);
+    }
+
+    auto idx = context.visited.At(cs);
     if (idx == -1) return std::string("eps");
     return constructDownward(idx);
 }
 
-std::span<CS> rei::BottomUpSearch::GetLastCostLevel() const {
+void rei::BottomUpSearch::Freeze() {
+    context.frozen.Build(context.cache);
+    context.visited.Release();
+    isFrozen = true;
+}
+
+const rei::FrozenLanguageIndex& rei::BottomUpSearch::Frozen() const {
+    return context.frozen;
+}
+
+void rei::BottomUpSearch::thaw() {
+    if (isFrozen) rebuildVisited();
+}
+
+rei::HybridCache::Range rei::BottomUpSearch::GetLastCostLevel() const {
     auto [start, end] = partitioner.Interval(costLevel - 1);
-    return std::span<CS>(context.cache + start, end - start);
+    return context.cache.Slice(start, end);
 }
 
-// Adding parentheses if needed
-std::string rei::BottomUpSearch::bracket(std::string s) const {
-    int p = 0;
-    for (int i = 0; i < s.length(); i++) {
-        if (s[i] == '(') p++;
-        else if (s[i] == ')') p--;
-        else if (s[i] == '+' && p <= 0) return "(" + s + ")";
-    }
-    return s;
+rei::HybridCache::Range rei::BottomUpSearch::GetStored() const {
+    return context.cache.Slice(static_cast<int>(alphabet.size()), context.lastIdx);
 }
 
-// Generating the final RE string recursively
-std::string rei::BottomUpSearch::constructDownward(int index) const {
+int rei::BottomUpSearch::ResumeLevel() const {
+    return lastFound ? costLevel - 1 : costLevel;
+}
+
+int rei::BottomUpSearch::ExactLevel() const {
+    return std::min(firstRejectedLevel, ResumeLevel());
+}
+
+bool rei::BottomUpSearch::Overflowed() const {
+    return context.onTheFly;
+}
+
+unsigned long rei::BottomUpSearch::AllREs() const {
+    return context.allREs;
+}
+
+int rei::BottomUpSearch::Stored() const {
+    return context.lastIdx;
+}
+
+double rei::BottomUpSearch::VisitedLoad() const {
+    return isFrozen ? context.frozen.LoadFactor() : context.visited.LoadFactor();
+}
+
+const std::vector<rei::LevelStats>& rei::BottomUpSearch::Stats() const {
+    return levelStats;
+}
+
+rei::OperationStats rei::BottomUpSearch::counters() const {
+    OperationStats stats;
+    stats.candidates = context.allREs;
+    stats.duplicates = context.rejected;
+    stats.goalChecks = context.goalChecks;
+    stats.lookups = context.visited.Lookups();
+    stats.probes = context.visited.Probes();
+    return stats;
+}
+
+void rei::BottomUpSearch::Rewind(int level) {
+
+    level = std::clamp(level, costs.alpha + 1, ResumeLevel());
+    if (level == costLevel) return;
+
+    costLevel = level;
+    lastFound = false;
+    if (firstRejectedLevel >= level) firstRejectedLevel = INT_MAX;
+
+    context.lastIdx = partitioner.start(level, Operation::Question);
+    context.cache.Truncate(context.lastIdx);
+
+    rebuildVisited();
+}
 
-    if (index == -2) return "eps"; // Epsilon
-    if (index < alphabet.size()) { std::string s(1, *next(alphabet.begin(), index)); return s; }
+CS remapBits(const CS& cs, const std::vector<int>& newIndex) {
+    CS res;
+    for (int i = 0; i < static_cast<int>(newIndex.size()); i++)
+        if (cs.test(i)) res.set(newIndex[i]);
+    return res;
+}
+
+void rei::BottomUpSearch::Remap(const std::vector<int>& newIndex, const std::vector<int>& newWords) {
+
+    // the IC grew, the goal check has to look at the words of the new bits
+    context.words = guideTable.Words();
 
-    int cost; Operation op;
-    partitioner.indexToLevel(index, cost, op);
+    // the sizes of the stored languages change with the words, so they are pushed again into a new cache
+    HybridCache remapped;
+    remapped.Reserve(context.lastIdx);
+    remapped.Reset(context.words);
+    for (int i = 0; i < static_cast<int>(alphabet.size()); i++)
+        remapped.Push(context.cache.Get(i));
 
-    if (op == Operation::Question) {
-        std::string res = constructDownward(context.leftRightIdx[index << 1]);
-        if (res.length() > 1) return "(" + res + ")?";
-        return res + "?";
+    auto languageOf = [&remapped](int index) {
+        return index == Provenance::Eps ? CS::one() : remapped.Get(index);
+    };
+
+    // children are stored before their parents, so every child is already in the new IC
+    for (int i = static_cast<int>(alphabet.size()); i < context.lastIdx; i++)
+    {
+        auto from = context.provenance[i];
+        const CS left = languageOf(from.Left());
+        CS cs;
+
+        switch (from.Op()) {
+        case Operation::Question:
+            cs = processQuestion(left);
+            break;
+        case Operation::Or:
+            cs = processOr(left, languageOf(from.Right()));
+            break;
+        case Operation::Star:
+            cs = remapBits(context.cache.Get(i), newIndex);
+            // the old bits are exact, only the rows of the new infixes need to be checked. the parts
+            // of an infix are shorter, so they are already final when the infix is reached
+            for (int ix : newWords) {
+                if (left.test(ix)) { cs.set(ix); continue; }
+                for (auto [l, r] : guideTable.IterateRow(ix)) {
+                    if (cs.test(l) && cs.test(r)) { cs.set(ix); break; }
+                }
+            }
+            break;
+        case Operation::Concatenate: {
+            const CS right = languageOf(from.Right());
+            cs = remapBits(context.cache.Get(i), newIndex);
+            for (int ix : newWords) {
+                if ((left.test(0) && right.test(ix)) || (right.test(0) && left.test(ix))) { cs.set(ix); continue; }
+                for (auto [l, r] : guideTable.IterateRow(ix)) {
+                    if (left.test(l) && right.test(r)) { cs.set(ix); break; }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        remapped.Push(cs);
     }
 
-    if (op == Operation::Star) {
-        std::string res = constructDownward(context.leftRightIdx[index << 1]);
-        if (res.length() > 1) return "(" + res + ")*";
-        return res + "*";
+    context.cache.Swap(remapped);
+    rebuildVisited();
+}
+
+void rei::BottomUpSearch::rebuildVisited() {
+    isFrozen = false;
+    context.frozen.Clear();
+    context.visited.Clear();
+    context.visited[CS()] = -1;
+    context.visited[CS::one()] = -1;
+    for (int i = 0; i < context.lastIdx; i++)
+        context.visited[context.cache.Get(i)] = i;
+}
+
+void rei::BottomUpSearch::Save(CheckpointWriter& writer) const {
+    writer.Write(costLevel);
+    writer.Write(shortageCost);
+    writer.Write(firstRejectedLevel);
+    writer.Write(lastRound);
+    writer.Write(lastFound);
+
+    writer.Write(context.lastIdx);
+    writer.Write(context.allREs);
+    writer.Write(context.rejected);
+    writer.Write(context.onTheFly);
+
+    // the file keeps whole languages, it does not depend on how the cache stores them
+    for (int i = 0; i < context.lastIdx; i++)
+        writer.Write(context.cache.Get(i));
+    writer.WriteArray(context.provenance, static_cast<size_t>(context.lastIdx));
+
+    partitioner.Save(writer);
+}
+
+bool rei::BottomUpSearch::Load(CheckpointReader& reader) {
+    int level, shortage, rejectedLevel, lastIdx;
+    bool round, found, onTheFly;
+    unsigned long allREs, rejected;
+
+    reader.Read(level);
+    reader.Read(shortage);
+    reader.Read(rejectedLevel);
+    reader.Read(round);
+    reader.Read(found);
+
+    reader.Read(lastIdx);
+    reader.Read(allREs);
+    reader.Read(rejected);
+    reader.Read(onTheFly);
+
+    if (!reader.Good() || lastIdx < static_cast<int>(alphabet.size()) || lastIdx > context.cache_capacity) return false;
+
+    // the languages are only taken when the whole file was read
+    HybridCache loaded;
+    loaded.Reserve(lastIdx);
+    loaded.Reset(context.words);
+    for (int i = 0; i < lastIdx; i++) {
+        CS cs;
+        if (!reader.Read(cs)) return false;
+        loaded.Push(cs);
     }
 
-    if (op == Operation::Concatenate) {
-        std::string left = constructDownward(context.leftRightIdx[index << 1]);
-        std::string right = constructDownward(context.leftRightIdx[(index << 1) + 1]);
-        return bracket(left) + bracket(right);
+    std::vector<Provenance> provenance(lastIdx);
+    if (!reader.ReadArray(provenance.data(), provenance.size())) return false;
+
+    // every operand was stored before the language built from it, which also keeps constructDownward from looping
+    for (int i = static_cast<int>(alphabet.size()); i < lastIdx; i++) {
+        auto from = provenance[i];
+        auto stored = [i](int operand) { return operand >= 0 && operand < i; };
+        bool unary = from.Op() == Operation::Question || from.Op() == Operation::Star;
+        bool eps = from.Op() == Operation::Or && from.Left() == Provenance::Eps;
+        if (!(eps || stored(from.Left())) || !(unary || stored(from.Right()))) return false;
     }
 
-    if (op == Operation::Or)
+    std::vector<int> points;
+    if (!partitioner.Load(reader, points, lastIdx)) return false;
+
+    // the alphabets at the front are the same in the file, the rest of the buffer is unused until the end
+    std::copy(provenance.begin(), provenance.end(), context.provenance);
+    partitioner.Assign(points);
+    context.cache.Swap(loaded);
+
+    costLevel = level;
+    shortageCost = shortage;
+    firstRejectedLevel = rejectedLevel;
+    lastRound = round;
+    lastFound = found;
+
+    context.lastIdx = lastIdx;
+    context.allREs = allREs;
+    context.rejected = rejected;
+    context.onTheFly = onTheFly;
+
+    rebuildVisited();
+    return true;
+}
+
+bool rei::BottomUpSearch::FindStored(BottomUpSearchResult& res) const {
+    for (int i = 0; i < context.lastIdx; i++)
     {
-        std::string left = constructDownward(context.leftRightIdx[index << 1]);
-        std::string right = constructDownward(context.leftRightIdx[(index << 1) + 1]);
-        return left + "+" + right;
+        if (context.IsSolution(context.cache.Get(i))) {
+            Operation op;
+            partitioner.indexToLevel(i, res.cost, op);
+            res.RE = constructDownward(i);
+            res.allREs = context.allREs;
+            return true;
+        }
     }
+    return false;
+}
+
+std::string rei::BottomUpSearch::constructDownward(int index) const {
+
+    // an operand to write, or a literal when node is None
+    constexpr int None = -1;
+    struct Task {
+        int node;
+        char literal;
+    };
+
+    auto isLetter = [this](int node) { return node >= 0 && node < static_cast<int>(letters.size()); };
+    // an alternation is the only RE with a '+' outside of parentheses
+    auto isOr = [this, &isLetter](int node) {
+        return node >= 0 && !isLetter(node) && context.provenance[node].Op() == Operation::Or;
+    };
+
+    std::string re;
+    std::vector<Task> tasks = { { index, 0 } };
+    auto push = [&tasks](int node, bool parenthesized) {
+        if (parenthesized) tasks.push_back({ None, ')' });
+        tasks.push_back({ node, 0 });
+        if (parenthesized) tasks.push_back({ None, '(' });
+    };
+
+    while (!tasks.empty()) {
+        auto [node, literal] = tasks.back();
+        tasks.pop_back();
+
+        if (node == None) { re += literal; continue; }
+        if (node == Provenance::Eps) { re += "eps"; continue; }
+        if (isLetter(node)) { re += letters[node]; continue; }
+
+        auto from = context.provenance[node];
+        switch (from.Op()) {
+        case Operation::Question:
+        case Operation::Star:
+            tasks.push_back({ None, from.Op() == Operation::Star ? '*' : '?' });
+            push(from.Left(), !isLetter(from.Left()));
+            break;
+        case Operation::Concatenate:
+            push(from.Right(), isOr(from.Right()));
+            push(from.Left(), isOr(from.Left()));
+            break;
+        case Operation::Or:
+            push(from.Right(), false);
+            tasks.push_back({ None, '+' });
+            push(from.Left(), false);
+            break;
+        default:
+            break;
+        }
+    }
+
+    return re;
 }
 
 rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
@@ -159,19 +440,20 @@ rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
         if (dif == costs.question || dif == costs.star || dif == costs.alpha + costs.concat || dif == costs.alpha + costs.alternation) lastRound = true;
     }
 
+    OperationTimer timer(levelStats.back(), [this] { return counters(); }, Operation::Question);
+
     //Question Mark
     if (costLevel >= costs.alpha + costs.question && useQuestionOverOr) {
 
         // ignore results from (*) and (?)
         auto [start, end] = partitioner.Interval(costLevel - costs.question, static_cast<Operation>(2));
-        auto pLevel = context.GetCacheSlice(start, end);
-        LOG_OP(context, costLevel, to_string(Operation::Question), end - start);
+        LOG_OP(context, costLevel, Operation::Question, end - start);
         for (auto i = start; i < end; i++)
         {
-            CS cs = pLevel[i - start];
-            if (!(cs & CS::one())) {
-                cs = processQuestion(cs);
-                if (context.InsertAndCheck(cs, i))
+            auto view = context.cache.View(i);
+            if (!view.test(0)) {
+                CS cs = processQuestion(view);
+                if (context.InsertAndCheck(cs, Provenance(Operation::Question, i)))
                 {
                     partitioner.end(costLevel, Operation::Question) = INT_MAX;
                     idx = context.lastIdx;
@@ -183,16 +465,15 @@ rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
     partitioner.end(costLevel, Operation::Question) = context.lastIdx;
 
     //Star
+    timer.Next(Operation::Star);
     if (costLevel >= costs.alpha + costs.star) {
         // ignore results from (*) and (?)
         auto [start, end] = partitioner.Interval(costLevel - costs.star, static_cast<Operation>(2));
-        auto pLevel = context.GetCacheSlice(start, end);
-        LOG_OP(context, costLevel, to_string(Operation::Star), end - start);
+        LOG_OP(context, costLevel, Operation::Star, end - start);
         for (auto i = start; i < end; i++)
         {
-            CS cs = pLevel[i - start];
-            cs = processStar(guideTable, cs);
-            if (context.InsertAndCheck(cs, i))
+            CS cs = processStar(guideTable, context.cache.View(i));
+            if (context.InsertAndCheck(cs, Provenance(Operation::Star, i)))
             {
                 partitioner.end(costLevel, Operation::Star) = INT_MAX;
                 idx = context.lastIdx;
@@ -203,29 +484,31 @@ rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
     partitioner.end(costLevel, Operation::Star) = context.lastIdx;
 
     //Concatenate
+    timer.Next(Operation::Concatenate);
     for (int i = costs.alpha; 2 * i <= costLevel - costs.concat; ++i) {
 
         auto [lstart, lend] = partitioner.Interval(i);
         auto [rstart, rend] = partitioner.Interval(costLevel - i - costs.concat);
-        auto lpLevel = context.GetCacheSlice(lstart, lend);
-        auto rpLevel = context.GetCacheSlice(rstart, rend);
-        LOG_OP(context, costLevel, to_string(Operation::Concatenate), 2 * (rend - rstart) * (lend - lstart));
+        LOG_OP(context, costLevel, Operation::Concatenate, 2 * (rend - rstart) * (lend - lstart));
 
         for (int l = lstart; l < lend; ++l) {
-            CS left = lpLevel[l - lstart];
             for (int r = rstart; r < rend; ++r) {
 
-                auto leftRight = processConcatenate(guideTable, left, rpLevel[r - rstart]);
-                auto rightLeft = processConcatenate(guideTable, rpLevel[r - rstart], left);
+                // a push can move the cache, so the views are taken again for every pair
+                auto left = context.cache.View(l);
+                auto right = context.cache.View(r);
+
+                auto leftRight = processConcatenate(guideTable, left, right);
+                auto rightLeft = processConcatenate(guideTable, right, left);
 
-                if (context.InsertAndCheck(leftRight, l, r))
+                if (context.InsertAndCheck(leftRight, Provenance(Operation::Concatenate, l, r)))
                 {
                     partitioner.end(costLevel, Operation::Concatenate) = INT_MAX;
                     idx = context.lastIdx;
                     return EnumerationState::Found;
                 }
 
-                if (context.InsertAndCheck(rightLeft, r, l))
+                if (context.InsertAndCheck(rightLeft, Provenance(Operation::Concatenate, r, l)))
                 {
                     partitioner.end(costLevel, Operation::Concatenate) = INT_MAX;
                     idx = context.lastIdx;
@@ -238,17 +521,17 @@ rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
     partitioner.end(costLevel, Operation::Concatenate) = context.lastIdx;
 
     //Union
+    timer.Next(Operation::Or);
     if (!useQuestionOverOr && costLevel >= 2 * costs.alpha + costs.alternation) {
 
         auto [rstart, rend] = partitioner.Interval(costLevel - costs.alpha - costs.alternation);
-        auto pLevel = context.GetCacheSlice(rstart, rend);
-        LOG_OP(context, costLevel, to_string(Operation::Or), rend - rstart);
+        LOG_OP(context, costLevel, Operation::Or, rend - rstart);
 
         for (int r = rstart; r < rend; ++r) {
 
-            CS cs = processOr(CS::one(), pLevel[r - rstart]);
+            CS cs = processOr(CS::one(), context.cache.Get(r));
 
-            if (context.InsertAndCheck(cs, -2, r))
+            if (context.InsertAndCheck(cs, Provenance(Operation::Or, Provenance::Eps, r)))
             {
                 partitioner.end(costLevel, Operation::Or) = INT_MAX;
                 idx = context.lastIdx;
@@ -260,16 +543,13 @@ rei::EnumerationState rei::BottomUpSearch::enumerateLevel(int& idx) {
 
         auto [lstart, lend] = partitioner.Interval(i);
         auto [rstart, rend] = partitioner.Interval(costLevel - i - costs.alternation);
-        auto lpLevel = context.GetCacheSlice(lstart, lend);
-        auto rpLevel = context.GetCacheSlice(rstart, rend);
-        LOG_OP(context, costLevel, to_string(Operation::Or), (rend - rstart) * (lend - lstart));
+        LOG_OP(context, costLevel, Operation::Or, (rend - rstart) * (lend - lstart));
         for (int l = lstart; l < lend; ++l) {
-            CS left = lpLevel[l - lstart];
             for (int r = rstart; r < rend; ++r) {
 
-                CS cs = processOr(left, rpLevel[r - rstart]);
+                CS cs = processOr(context.cache.View(l), context.cache.View(r));
 
-                if (context.InsertAndCheck(cs, l, r))
+                if (context.InsertAndCheck(cs, Provenance(Operation::Or, l, r)))
                 {
                     partitioner.end(costLevel, Operation::Or) = INT_MAX;
                     idx = context.lastIdx;
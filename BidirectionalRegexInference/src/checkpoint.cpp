@@ -0,0 +1,140 @@
+#include <checkpoint.hpp>
+
+#include <cstring>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <sstream>
+#include <filesystem>
+
+#include <types.h>
+#include <bottom_up.hpp>
+#include <top_down.hpp>
+
+namespace {
+    const char magic[8] = { 'R', 'E', 'I', 'C', 'K', 'P', 'T', '\0' };
+    const uint32_t version = 3;
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= UINT64_C(0x100000001b3);
+        }
+        return hash;
+    }
+
+    // a temporary name of its own for every writer, processes and threads that write the same path never share it
+    std::string temporaryPath(const std::string& path) {
+        static std::atomic<uint64_t> written = 0;
+        static const uint64_t process = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+
+        std::ostringstream name;
+        name << path << "." << std::hex << process << "." << std::hash<std::thread::id>{}(std::this_thread::get_id())
+            << "." << written++ << ".tmp";
+        return name.str();
+    }
+}
+
+rei::CheckpointWriter::CheckpointWriter(const std::string& path) :
+    path(path), tmpPath(temporaryPath(path)), out(tmpPath, std::ios::binary | std::ios::trunc) {
+}
+
+bool rei::CheckpointWriter::Commit() {
+    out.close();
+
+    std::error_code ec;
+    if (!out.fail()) {
+        std::filesystem::rename(tmpPath, path, ec);
+        if (!ec) return true;
+    }
+
+    // a file that was not renamed is not left behind
+    std::filesystem::remove(tmpPath, ec);
+    return false;
+}
+
+rei::CheckpointReader::CheckpointReader(const std::string& path) : in(path, std::ios::binary) {
+}
+
+rei::Checkpoint::Checkpoint(const CheckpointConfigs& configs, uint64_t fingerprint) :
+    configs(configs), fingerprint(fingerprint), lastSave(std::chrono::steady_clock::now()) {
+}
+
+bool rei::Checkpoint::Due() const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - lastSave;
+    return elapsed.count() >= configs.interval;
+}
+
+bool rei::Checkpoint::Save(const BottomUpSearch& bottomUp, const TopDownSearch* topDown) {
+
+    CheckpointWriter writer(configs.path);
+
+    writer.WriteArray(magic, sizeof(magic));
+    writer.Write(version);
+    writer.Write(static_cast<uint32_t>(sizeof(CS)));
+    writer.Write(fingerprint);
+    writer.Write(topDown ? CheckpointPhase::TopDown : CheckpointPhase::BottomUp);
+
+    bottomUp.Save(writer);
+    if (topDown) topDown->Save(writer);
+
+    lastSave = std::chrono::steady_clock::now();
+    return writer.Commit();
+}
+
+rei::CheckpointPhase rei::Checkpoint::Load(BottomUpSearch& bottomUp, TopDownSearch& topDown) {
+
+    CheckpointReader reader(configs.path);
+    if (!reader.IsOpen()) return CheckpointPhase::None;
+
+    char fileMagic[sizeof(magic)];
+    uint32_t fileVersion, csBytes;
+    uint64_t fileFingerprint;
+    CheckpointPhase phase;
+
+    if (!reader.ReadArray(fileMagic, sizeof(fileMagic)) || std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+        return CheckpointPhase::None;
+
+    reader.Read(fileVersion);
+    reader.Read(csBytes);
+    reader.Read(fileFingerprint);
+    reader.Read(phase);
+
+    if (!reader.Good() || fileVersion != version || csBytes != sizeof(CS) || fileFingerprint != fingerprint)
+        return CheckpointPhase::None;
+
+    // the searches only take the loaded state when their whole section was read
+    if (!bottomUp.Load(reader)) return CheckpointPhase::None;
+    if (phase == CheckpointPhase::TopDown && !topDown.Load(reader)) return CheckpointPhase::BottomUp;
+
+    return phase;
+}
+
+void rei::Checkpoint::Remove() {
+    std::error_code ec;
+    std::filesystem::remove(configs.path, ec);
+}
+
+uint64_t rei::checkpointFingerprint(const unsigned short* costFun, unsigned short maxCost, int buCacheCapacity, int tdCacheCapacity,
+    const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    hash = fnv1a(costFun, 5 * sizeof(unsigned short), hash);
+    hash = fnv1a(&maxCost, sizeof(maxCost), hash);
+    hash = fnv1a(&buCacheCapacity, sizeof(buCacheCapacity), hash);
+    hash = fnv1a(&tdCacheCapacity, sizeof(tdCacheCapacity), hash);
+
+    // the lengths keep ("ab", "c") and ("a", "bc") apart
+    for (const auto* words : { &pos, &neg }) {
+        uint64_t count = words->size();
+        hash = fnv1a(&count, sizeof(count), hash);
+        for (const auto& word : *words) {
+            uint64_t length = word.size();
+            hash = fnv1a(&length, sizeof(length), hash);
+            hash = fnv1a(word.data(), word.size(), hash);
+        }
+    }
+
+    return hash;
+}
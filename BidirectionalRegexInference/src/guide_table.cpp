@@ -1,5 +1,12 @@
 #include <guide_table.hpp>
 
+#include <checkpoint.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+#include <unordered_map>
+
 using namespace rei;
 
 // Shortlex ordering
@@ -10,33 +17,7 @@ struct strComparison {
     }
 };
 
-// Generating the infix of a string
-std::set<std::string, strComparison> infixesOf(const std::string& word) {
-    std::set<std::string, strComparison> ic;
-    for (int len = 0; len <= word.length(); ++len) {
-        for (int index = 0; index < word.length() - len + 1; ++index) {
-            ic.insert(word.substr(index, len));
-        }
-    }
-    return ic;
-}
-
-std::set<std::string, strComparison> generatingIC(const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
-    // Generating infix-closure (ic) of the input strings
-    std::set<std::string, strComparison> ic = {};
-
-    for (const std::string& word : pos) {
-        std::set<std::string, strComparison> set1 = infixesOf(word);
-        ic.insert(set1.begin(), set1.end());
-    }
-    for (const std::string& word : neg) {
-        std::set<std::string, strComparison> set1 = infixesOf(word);
-        ic.insert(set1.begin(), set1.end());
-    }
-    return ic;
-}
-
-bool generatingGuideTable(GuideTable* guideTable, const std::set<std::string, strComparison>& ic)
+bool buildGuideTable(GuideTable* guideTable, const std::vector<std::string>& ic)
 {
     int alphabetSize = -1;
     for (auto& word : ic) {
@@ -44,121 +25,196 @@ bool generatingGuideTable(GuideTable* guideTable, const std::set<std::string, st
         alphabetSize++;
     }
 
-    std::vector<std::vector<int>> gt;
+    if (ic.size() > sizeof(CS) * 8) {
+        printf("Your input needs %llu bits which exceeds %llu bits ", ic.size(), sizeof(CS) * 8);
+        printf("(current version).\nPlease use less/shorter words and run the code again.\n");
+        return false;
+    }
 
-    for (auto& word : ic) {
-        std::vector<int> row;
-        for (int i = 1; i < word.length(); ++i) {
+    std::unordered_map<std::string_view, int> index;
+    index.reserve(ic.size());
+    for (int i = 0; i < static_cast<int>(ic.size()); ++i)
+        index.emplace(ic[i], i);
+
+    // the IC is closed under infixes, so dropping the first or the last letter of a word gives another word
+    // of the IC. following these links walks all the prefixes and suffixes of a word in O(length)
+    std::vector<int> dropFirst(ic.size(), 0), dropLast(ic.size(), 0);
+    for (int i = 1; i < static_cast<int>(ic.size()); ++i) {
+        std::string_view word = ic[i];
+        dropFirst[i] = index.at(word.substr(1));
+        dropLast[i] = index.at(word.substr(0, word.length() - 1));
+    }
 
-            int index1 = 0;
-            for (auto& w : ic) {
-                if (w == word.substr(0, i)) break;
-                index1++;
-            }
-            int index2 = 0;
-            for (auto& w : ic) {
-                if (w == word.substr(i)) break;
-                index2++;
-            }
+    std::vector<int> rowStart;
+    std::vector<GuideTable::Split> splits;
+    rowStart.reserve(ic.size() + 1);
 
-            row.push_back(index1);
-            row.push_back(index2);
-        }
+    std::vector<int> prefixes, suffixes;
+    for (int w = 0; w < static_cast<int>(ic.size()); ++w) {
+        const int length = static_cast<int>(ic[w].length());
 
-        row.push_back(0);
-        gt.push_back(row);
-    }
+        // prefixes[i] is the index of word[0, i), suffixes[i] the index of word[i, length)
+        prefixes.assign(length + 1, 0);
+        suffixes.assign(length + 1, 0);
+        for (int i = length - 1, p = w; i > 0; --i) prefixes[i] = p = dropLast[p];
+        for (int i = 1, s = w; i < length; ++i) suffixes[i] = s = dropFirst[s];
 
-    if (gt.size() > sizeof(CS) * 8) {
-        printf("Your input needs %llu bits which exceeds %llu bits ", gt.size(), sizeof(CS) * 8);
-        printf("(current version).\nPlease use less/shorter words and run the code again.\n");
-        return false;
+        rowStart.push_back(static_cast<int>(splits.size()));
+        for (int i = 1; i < length; ++i)
+            splits.push_back({ static_cast<GuideIndex>(prefixes[i]), static_cast<GuideIndex>(suffixes[i]) });
     }
+    rowStart.push_back(static_cast<int>(splits.size()));
 
-    new (guideTable) GuideTable(gt, alphabetSize);
+    *guideTable = GuideTable(std::move(rowStart), std::move(splits), alphabetSize);
     return true;
 }
 
+std::vector<std::string> rei::generatingIC(const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+    // Generating infix-closure (ic) of the input strings, the views point into the examples so
+    // an infix is only copied once
+    std::vector<std::unordered_set<std::string_view>> byLength(1);
+
+    for (const auto* words : { &pos, &neg }) {
+        for (const std::string& word : *words) {
+            if (word.length() >= byLength.size()) byLength.resize(word.length() + 1);
+            for (size_t len = 1; len <= word.length(); ++len) {
+                for (size_t index = 0; index + len <= word.length(); ++index) {
+                    byLength[len].insert(std::string_view(word).substr(index, len));
+                }
+            }
+        }
+    }
+
+    // shortlex order, by length and then lexicographically within a length
+    std::vector<std::string> ic = { std::string() };
+    for (auto& infixes : byLength) {
+        std::vector<std::string_view> sorted(infixes.begin(), infixes.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (auto infix : sorted) ic.emplace_back(infix);
+    }
+    return ic;
+}
+
+int rei::indexOfWord(const std::vector<std::string>& ic, const std::string& word) {
+    auto it = std::lower_bound(ic.begin(), ic.end(), word, strComparison());
+    if (it == ic.end() || *it != word) return -1;
+    return static_cast<int>(distance(ic.begin(), it));
+}
+
 bool rei::generatingGuideTable(GuideTable& guideTable, CS& posBits, CS& negBits,
     const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+    return generatingGuideTable(guideTable, posBits, negBits, generatingIC(pos, neg), pos, neg);
+}
 
-    std::set<std::string, strComparison> ic = generatingIC(pos, neg);
+bool rei::generatingGuideTable(GuideTable& guideTable, CS& posBits, CS& negBits, const std::vector<std::string>& ic,
+    const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
 
-    if (!generatingGuideTable(&guideTable, ic))
+    if (!buildGuideTable(&guideTable, ic))
         return false;
 
     for (auto& p : pos) {
-        int wordIndex = distance(ic.begin(), ic.find(p));
-        posBits |= (CS::one() << wordIndex);
+        int wordIndex = indexOfWord(ic, p);
+        posBits.set(wordIndex);
     }
 
     for (auto& n : neg) {
-        int wordIndex = distance(ic.begin(), ic.find(n));
-        negBits |= (CS::one() << wordIndex);
+        int wordIndex = indexOfWord(ic, n);
+        negBits.set(wordIndex);
     }
 
     return true;
 }
 
 
-rei::GuideTable::Iterator::Iterator(const int* p) : ptr(p) {}
+rei::GuideTable::GuideTable(std::vector<int> rowStart, std::vector<Split> splits, int alphabetSize) :
+    ICsize(static_cast<int>(rowStart.size()) - 1), alphabetSize(alphabetSize), rowStart(std::move(rowStart)), splits(std::move(splits))
+{
+    buildAdjacency();
+}
 
-rei::Pair<int> rei::GuideTable::Iterator::operator*() const { return Pair<int>(*ptr, *(ptr + 1)); }
-rei::GuideTable::Iterator& rei::GuideTable::Iterator::operator++() { ptr += 2; return *this; }
-bool rei::GuideTable::Iterator::operator!=(const Iterator& solved) const { return *ptr; }
+rei::GuideTable::GuideTable() : ICsize(0), alphabetSize(0), rowStart(1, 0), adjacentStart(1, 0), precedingStart(1, 0) {}
 
-rei::GuideTable::RowIterator::RowIterator(const int* data, int gtColumns, int rowIndex) : row(rowIndex), data(data), gtColumns(gtColumns) {}
-rei::GuideTable::Iterator rei::GuideTable::RowIterator::begin() { return Iterator(data + row * gtColumns); }
-rei::GuideTable::Iterator rei::GuideTable::RowIterator::end() { return Iterator(data + (row + 1) * gtColumns); }
+void rei::GuideTable::Save(CheckpointWriter& writer) const {
+    writer.Write(alphabetSize);
+    writer.Write(static_cast<uint64_t>(rowStart.size()));
+    writer.WriteArray(rowStart.data(), rowStart.size());
+    writer.Write(static_cast<uint64_t>(splits.size()));
+    writer.WriteArray(splits.data(), splits.size());
+}
 
+bool rei::GuideTable::Load(CheckpointReader& reader) {
+    int fileAlphabetSize;
+    uint64_t rows, count;
 
-rei::GuideTable::GuideTable(std::vector<std::vector<int>> gt, int alphabetSize) : alphabetSize(alphabetSize)
-{
-    ICsize = static_cast<int> (gt.size());
-    gtColumns = static_cast<int> (gt.back().size());
+    // eps is always in the IC, a table has at least one word and its letters come after eps
+    if (!reader.Read(fileAlphabetSize) || !reader.Read(rows) || rows < 2 || rows > sizeof(CS) * 8 + 1) return false;
 
-    data = new int[ICsize * gtColumns];
+    std::vector<int> fileRowStart(rows);
+    if (!reader.ReadArray(fileRowStart.data(), rows) || !reader.Read(count) || count != static_cast<uint64_t>(fileRowStart.back()))
+        return false;
 
-    for (int i = 0; i < ICsize; ++i) {
-        for (int j = 0; j < gt.at(i).size(); ++j) {
-            data[i * gtColumns + j] = gt.at(i).at(j);
-        }
-    }
+    // the adjacency is built by indexing with the file's values, so a damaged file has to fail here
+    int fileICsize = static_cast<int>(rows) - 1;
+    if (fileRowStart[0] != 0 || fileAlphabetSize < 0 || fileAlphabetSize >= fileICsize) return false;
+    for (size_t i = 1; i < rows; i++)
+        if (fileRowStart[i] < fileRowStart[i - 1]) return false;
 
-    // construct the adjacency list
-    {
-        std::vector<std::pair<int, int>> row;
+    std::vector<Split> fileSplits(count);
+    if (!reader.ReadArray(fileSplits.data(), count)) return false;
 
-        for (int i = 0; i < ICsize; i++)
-            row.emplace_back(i, i);
+    for (auto [left, right] : fileSplits)
+        if (static_cast<int>(left) < 0 || static_cast<int>(left) >= fileICsize || static_cast<int>(right) < 0 || static_cast<int>(right) >= fileICsize)
+            return false;
 
-        adjacencyList.push_back(row);
-    }
+    *this = GuideTable(std::move(fileRowStart), std::move(fileSplits), fileAlphabetSize);
+    return true;
+}
+
+void rei::GuideTable::buildAdjacency()
+{
+    // construct the adjacency list, eps on either side comes first and then the splits in row order
+    std::vector<int> count(ICsize, 1);
+    count[0] = ICsize;
+    for (auto [left, right] : splits)
+        count[left]++;
+
+    adjacentStart.assign(ICsize + 1, 0);
+    for (int i = 0; i < ICsize; i++)
+        adjacentStart[i + 1] = adjacentStart[i] + count[i];
+
+    adjacent.resize(adjacentStart[ICsize]);
+    std::vector<int> next(adjacentStart.begin(), adjacentStart.end() - 1);
+
+    for (int i = 0; i < ICsize; i++)
+        adjacent[next[0]++] = { static_cast<GuideIndex>(i), static_cast<GuideIndex>(i) };
 
     for (int i = 1; i < ICsize; i++)
-    {
-        std::vector<std::pair<int, int>> row;
-        row.emplace_back(0, i);
-        adjacencyList.push_back(row);
-    }
+        adjacent[next[i]++] = { 0, static_cast<GuideIndex>(i) };
 
-    for (int i = 0; i < ICsize; ++i) {
-        for (int j = 0; j < gt.at(i).size() - 1; j += 2) {
-            auto left_index = gt.at(i).at(j);
-            auto right_index = gt.at(i).at(j + 1);
-            adjacencyList[left_index].emplace_back(right_index, i);
-        }
-    }
-}
+    for (int i = 0; i < ICsize; ++i)
+        for (auto [left, right] : IterateRow(i))
+            adjacent[next[left]++] = { right, static_cast<GuideIndex>(i) };
 
-rei::GuideTable::GuideTable() : ICsize(0), gtColumns(0), alphabetSize(0), data(nullptr) {}
+    // the same by the right part
+    std::fill(count.begin(), count.end(), 1);
+    count[0] = ICsize;
+    for (auto [left, right] : splits)
+        count[right]++;
 
-rei::GuideTable::~GuideTable() {
-    if (data != nullptr) {
-        delete[] data;
-    }
-}
+    precedingStart.assign(ICsize + 1, 0);
+    for (int i = 0; i < ICsize; i++)
+        precedingStart[i + 1] = precedingStart[i] + count[i];
+
+    preceding.resize(precedingStart[ICsize]);
+    next.assign(precedingStart.begin(), precedingStart.end() - 1);
+
+    for (int i = 0; i < ICsize; i++)
+        preceding[next[0]++] = { static_cast<GuideIndex>(i), static_cast<GuideIndex>(i) };
+
+    for (int i = 1; i < ICsize; i++)
+        preceding[next[i]++] = { 0, static_cast<GuideIndex>(i) };
 
-rei::GuideTable::RowIterator rei::GuideTable::IterateRow(int rowIndex) const {
-    return RowIterator(data, gtColumns, rowIndex);
+    for (int i = 0; i < ICsize; ++i)
+        for (auto [left, right] : IterateRow(i))
+            preceding[next[right]++] = { left, static_cast<GuideIndex>(i) };
 }
@@ -0,0 +1,166 @@
+#include <guide_table_cache.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#include <checkpoint.hpp>
+#include <rei_common.hpp>
+
+namespace {
+    const char magic[8] = { 'R', 'E', 'I', 'G', 'T', 'B', 'L', '\0' };
+    const uint32_t version = 1;
+
+    std::vector<std::string> canonical(const std::vector<std::string>& words) {
+        std::vector<std::string> sorted(words);
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        return sorted;
+    }
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= UINT64_C(0x100000001b3);
+        }
+        return hash;
+    }
+
+    void writeWords(rei::CheckpointWriter& writer, const std::vector<std::string>& words) {
+        writer.Write(static_cast<uint64_t>(words.size()));
+        for (const auto& word : words) {
+            writer.Write(static_cast<uint64_t>(word.size()));
+            writer.WriteArray(word.data(), word.size());
+        }
+    }
+
+    // compare the stored words with the expected ones, a different set with the same key is a miss
+    bool matchWords(rei::CheckpointReader& reader, const std::vector<std::string>& words) {
+        uint64_t count;
+        if (!reader.Read(count) || count != words.size()) return false;
+        std::string word;
+        for (const auto& expected : words) {
+            uint64_t length;
+            if (!reader.Read(length) || length != expected.size()) return false;
+            word.resize(length);
+            if (!reader.ReadArray(word.data(), length) || word != expected) return false;
+        }
+        return true;
+    }
+}
+
+rei::GuideTableCache::GuideTableCache(const std::string& directory) : directory(directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+}
+
+bool rei::GuideTableCache::Get(GuideTable& guideTable, CS& posBits, CS& negBits, std::set<char>& alphabets,
+    const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+
+    auto sortedPos = canonical(pos);
+    auto sortedNeg = canonical(neg);
+    auto key = exampleSetKey(sortedPos, sortedNeg);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.gt", static_cast<unsigned long long>(key));
+    auto path = (std::filesystem::path(directory) / name).string();
+
+    if (load(path, key, sortedPos, sortedNeg, guideTable, posBits, negBits, alphabets)) {
+        hits++;
+        return true;
+    }
+    misses++;
+
+    if (!generatingGuideTable(guideTable, posBits, negBits, pos, neg)) return false;
+    alphabets = findAlphabets(pos, neg);
+
+    if (!store(path, key, sortedPos, sortedNeg, guideTable, posBits, negBits, alphabets)) failedStores++;
+    return true;
+}
+
+bool rei::GuideTableCache::load(const std::string& path, uint64_t key, const std::vector<std::string>& pos, const std::vector<std::string>& neg,
+    GuideTable& guideTable, CS& posBits, CS& negBits, std::set<char>& alphabets) {
+
+    CheckpointReader reader(path);
+    if (!reader.IsOpen()) return false;
+
+    char fileMagic[sizeof(magic)];
+    uint32_t fileVersion, csBytes;
+    uint64_t fileKey;
+
+    if (!reader.ReadArray(fileMagic, sizeof(fileMagic)) || std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+        return false;
+
+    reader.Read(fileVersion);
+    reader.Read(csBytes);
+    reader.Read(fileKey);
+
+    if (!reader.Good() || fileVersion != version || csBytes != sizeof(CS) || fileKey != key)
+        return false;
+
+    if (!matchWords(reader, pos) || !matchWords(reader, neg)) return false;
+
+    uint64_t alphabetCount;
+    if (!reader.Read(alphabetCount) || alphabetCount > 256) return false;
+    std::string letters(alphabetCount, '\0');
+    CS filePosBits, fileNegBits;
+    if (!reader.ReadArray(letters.data(), alphabetCount) || !reader.Read(filePosBits) || !reader.Read(fileNegBits))
+        return false;
+
+    // the table is the last section, nothing is changed unless it was read completely
+    GuideTable fileTable;
+    if (!fileTable.Load(reader)) return false;
+
+    guideTable = std::move(fileTable);
+    posBits = filePosBits;
+    negBits = fileNegBits;
+    alphabets = std::set<char>(letters.begin(), letters.end());
+    return true;
+}
+
+bool rei::GuideTableCache::store(const std::string& path, uint64_t key, const std::vector<std::string>& pos, const std::vector<std::string>& neg,
+    const GuideTable& guideTable, const CS& posBits, const CS& negBits, const std::set<char>& alphabets) {
+
+    // written to a temporary file of this writer and renamed, so a reader never sees half a file
+    CheckpointWriter writer(path);
+
+    writer.WriteArray(magic, sizeof(magic));
+    writer.Write(version);
+    writer.Write(static_cast<uint32_t>(sizeof(CS)));
+    writer.Write(key);
+
+    writeWords(writer, pos);
+    writeWords(writer, neg);
+
+    std::string letters(alphabets.begin(), alphabets.end());
+    writer.Write(static_cast<uint64_t>(letters.size()));
+    writer.WriteArray(letters.data(), letters.size());
+    writer.Write(posBits);
+    writer.Write(negBits);
+
+    guideTable.Save(writer);
+    return writer.Commit();
+}
+
+uint64_t rei::exampleSetKey(const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    uint32_t csBytes = sizeof(CS);
+    hash = fnv1a(&version, sizeof(version), hash);
+    hash = fnv1a(&csBytes, sizeof(csBytes), hash);
+
+    for (const auto* words : { &pos, &neg }) {
+        auto sorted = canonical(*words);
+        uint64_t count = sorted.size();
+        hash = fnv1a(&count, sizeof(count), hash);
+        for (const auto& word : sorted) {
+            uint64_t length = word.size();
+            hash = fnv1a(&length, sizeof(length), hash);
+            hash = fnv1a(word.data(), word.size(), hash);
+        }
+    }
+
+    return hash;
+}
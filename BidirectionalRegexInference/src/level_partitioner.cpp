@@ -1,8 +1,14 @@
 #include <level_partitioner.hpp>
 
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <checkpoint.hpp>
+
 rei::LevelPartitioner::LevelPartitioner(const unsigned short maxCost) {
     opCount = static_cast<int>(Operation::Count);
-    startPoints = new int[(maxCost + 1) * opCount]();
+    size = (maxCost + 1) * opCount;
+    startPoints = new int[size]();
 }
 
 rei::LevelPartitioner::~LevelPartitioner() {
@@ -35,4 +41,25 @@ void rei::LevelPartitioner::indexToLevel(int index, int& level, Operation& op) c
     i--;
     level = i / opCount;
     op = static_cast<Operation>(i % opCount);
-}
\ No newline at end of file
+}
+
+void rei::LevelPartitioner::Save(CheckpointWriter& writer) const {
+    writer.Write(size);
+    writer.WriteArray(startPoints, size);
+}
+
+bool rei::LevelPartitioner::Load(CheckpointReader& reader, std::vector<int>& points, int lastIdx) const {
+    int fileSize;
+    if (!reader.Read(fileSize) || fileSize != size) return false;
+
+    points.resize(size);
+    if (!reader.ReadArray(points.data(), size)) return false;
+
+    return std::all_of(points.begin(), points.end(), [lastIdx](int point) {
+        return point == INT_MAX || (point >= 0 && point <= lastIdx);
+    });
+}
+
+void rei::LevelPartitioner::Assign(const std::vector<int>& points) {
+    std::copy(points.begin(), points.end(), startPoints);
+}
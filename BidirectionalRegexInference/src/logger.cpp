@@ -0,0 +1,72 @@
+#include <logger.hpp>
+
+#include <chrono>
+
+rei::Logger& rei::Logger::Instance() {
+    static Logger logger;
+    return logger;
+}
+
+rei::Logger::Logger() : ring(new Record[capacity]) {
+    // a record is free for the writer at position p when its sequence is p, and ready to print when it is p + 1
+    for (size_t i = 0; i < capacity; i++) ring[i].sequence.store(i, std::memory_order_relaxed);
+    writer = std::thread(&Logger::run, this);
+}
+
+rei::Logger::~Logger() {
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+}
+
+rei::Logger::Record* rei::Logger::acquire() {
+    auto position = tail.load(std::memory_order_relaxed);
+    for (;;) {
+        auto& record = ring[position & (capacity - 1)];
+        auto difference = static_cast<int64_t>(record.sequence.load(std::memory_order_acquire) - position);
+        if (difference == 0) {
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &record;
+        }
+        else if (difference < 0) {
+            // the record one lap behind was not printed yet
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+            position = tail.load(std::memory_order_relaxed);
+    }
+}
+
+void rei::Logger::publish(Record* record) {
+    record->sequence.store(record->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool rei::Logger::drain() {
+    bool written = false;
+    for (;;) {
+        auto position = head.load(std::memory_order_relaxed);
+        auto& record = ring[position & (capacity - 1)];
+        if (record.sequence.load(std::memory_order_acquire) != position + 1) break;
+
+        record.print(record, stderr);
+        record.sequence.store(position + capacity, std::memory_order_release);
+        head.store(position + 1, std::memory_order_release);
+        written = true;
+    }
+    if (written) std::fflush(stderr);
+    return written;
+}
+
+void rei::Logger::run() {
+    while (!stopping.load(std::memory_order_acquire))
+        if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    drain();
+
+    if (auto count = Dropped())
+        std::fprintf(stderr, "%llu log records were dropped\n", static_cast<unsigned long long>(count));
+}
+
+void rei::Logger::Flush() {
+    auto target = tail.load(std::memory_order_acquire);
+    while (head.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
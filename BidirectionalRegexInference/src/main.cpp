@@ -4,83 +4,209 @@
 #include <util.hpp>
 #include <rei.hpp>
 #include <chrono>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
 
-#include <regex_match.hpp>
-
-int calculateCost(const std::string& pattren, unsigned short* costFun) {
-    auto counts = rei::countOpreations(pattren);
-    int count = 0;
-    count += counts.alpha * costFun[0];
-    count += counts.question * costFun[1];
-    count += counts.star * costFun[2];
-    count += counts.concat * costFun[3];
-    count += counts.alternation * costFun[4];
-    return count;
+#include <batch.hpp>
+#include <logger.hpp>
+
+bool parseCosts(int argc, const char* argv[], int first, unsigned short* costFun, unsigned short& maxCost) {
+    bool argError = false;
+    for (int i = first; i < first + 6; ++i) {
+        if (i >= argc || std::atoi(argv[i]) <= 0 || std::atoi(argv[i]) > SHRT_MAX) {
+            printf("Argument number %d, \"%s\", should be a positive short integer.\n", i, i < argc ? argv[i] : "");
+            argError = true;
+        }
+    }
+    if (argError) return false;
+
+    for (int i = 0; i < 5; i++)
+        costFun[i] = std::atoi(argv[first + i]);
+    maxCost = std::atoi(argv[first + 5]);
+    return true;
+}
+
+int batchMain(int argc, const char* argv[]) {
+
+    if (argc < 9) {
+        printf("Arguments should be in the form of\n");
+        printf("-----------------------------------------------------------------\n");
+        printf("%s --batch <directory|file_list> <c1> <c2> <c3> <c4> <c5> <max_cost>\n", argv[0]);
+        printf("    [--threads <n>] [--memory <MB per job>] [--format csv|jsonl] [--out <file>]\n");
+        printf("    [--gt-cache <directory>] [--dedupe exact|fingerprint]\n");
+        printf("-----------------------------------------------------------------\n");
+        return 0;
+    }
+
+    unsigned short costFun[5];
+    unsigned short maxCost;
+    if (!parseCosts(argc, argv, 3, costFun, maxCost)) return 0;
+
+    rei::BatchConfigs configs;
+    std::string outName;
+
+    for (int i = 9; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--threads") && hasValue)
+            configs.threads = std::atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--memory") && hasValue)
+            configs.jobMemory = std::strtoull(argv[++i], nullptr, 10) << 20;
+        else if (!strcmp(argv[i], "--format") && hasValue) {
+            std::string format = argv[++i];
+            if (format != "csv" && format != "jsonl") {
+                printf("Unknown format \"%s\", expected csv or jsonl\n", format.c_str());
+                return 0;
+            }
+            configs.format = format == "jsonl" ? rei::BatchFormat::JSONLines : rei::BatchFormat::CSV;
+        }
+        else if (!strcmp(argv[i], "--out") && hasValue)
+            outName = argv[++i];
+        else if (!strcmp(argv[i], "--gt-cache") && hasValue)
+            configs.guideTableCache = argv[++i];
+        else if (!strcmp(argv[i], "--dedupe") && hasValue) {
+            std::string mode = argv[++i];
+            if (mode != "exact" && mode != "fingerprint") {
+                printf("Unknown dedupe mode \"%s\", expected exact or fingerprint\n", mode.c_str());
+                return 0;
+            }
+            configs.dedupe = mode == "fingerprint" ? rei::DedupeMode::Fingerprint : rei::DedupeMode::Exact;
+        }
+        else {
+            printf("Unknown argument \"%s\"\n", argv[i]);
+            return 0;
+        }
+    }
+
+    auto files = rei::collectBatchFiles(argv[2]);
+    if (files.empty()) {
+        printf("No example files were found in \"%s\"\n", argv[2]);
+        return 0;
+    }
+
+    // same naming as scripts/run_batch.py, the name of the directory
+    if (outName.empty()) {
+        outName = std::filesystem::path(argv[2]).lexically_normal().filename().string();
+        if (outName.empty()) outName = std::filesystem::path(argv[2]).parent_path().filename().string();
+        outName += configs.format == rei::BatchFormat::CSV ? ".csv" : ".jsonl";
+    }
+
+    std::ofstream out(outName);
+    if (!out.is_open()) {
+        printf("Unable to open \"%s\"\n", outName.c_str());
+        return 0;
+    }
+
+    rei::RunBatch(files, costFun, maxCost, configs, out);
+    LOG_FLUSH();
+
+    printf("\nSaved results of %zu files to %s\n", files.size(), outName.c_str());
+    return 0;
 }
 
 int main(int argc, const char* argv[]) {
 
+    if (argc > 1 && !strcmp(argv[1], "--batch"))
+        return batchMain(argc, argv);
+
     // -----------------
     // Reading the input
     // -----------------
 
-    if (argc != 8) {
+    std::string checkpointPath;
+    bool ndjson = false;
+
+    // the options follow the costs
+    bool argError = argc < 8;
+    for (int i = 8; i < argc && !argError; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--checkpoint") && hasValue)
+            checkpointPath = argv[++i];
+        else if (!strcmp(argv[i], "--format") && hasValue) {
+            std::string format = argv[++i];
+            ndjson = format == "ndjson";
+            argError = !ndjson && format != "text";
+        }
+        else
+            argError = true;
+    }
+
+    if (argError) {
         printf("Arguments should be in the form of\n");
         printf("-----------------------------------------------------------------\n");
-        printf("%s <file_address> <c1> <c2> <c3> <c4> <c5> <max_cost>\n", argv[0]);
+        printf("%s <file_address> <c1> <c2> <c3> <c4> <c5> <max_cost> [--checkpoint <file>] [--format text|ndjson]\n", argv[0]);
         printf("-----------------------------------------------------------------\n");
         printf("\nFor example\n");
         printf("-----------------------------------------------------------------\n");
         printf("%s ./input 1 12 60 1 1 1 1 1 1 500\n", argv[0]);
         printf("-----------------------------------------------------------------\n");
+        printf("\nOr, to run all the example files of a directory\n");
+        printf("-----------------------------------------------------------------\n");
+        printf("%s --batch <directory|file_list> <c1> <c2> <c3> <c4> <c5> <max_cost> [options]\n", argv[0]);
+        printf("-----------------------------------------------------------------\n");
         return 0;
     }
 
-    bool argError = false;
-    for (int i = 2; i < argc; ++i) {
-        if (std::atoi(argv[i]) <= 0 || std::atoi(argv[i]) > SHRT_MAX) {
-            printf("Argument number %d, \"%s\", should be a positive short integer.\n", i, argv[i]);
-            argError = true;
-        }
-    }
-    if (argError) return 0;
+    unsigned short costFun[5];
+    unsigned short maxCost;
+    if (!parseCosts(argc, argv, 2, costFun, maxCost)) return 0;
 
     std::string fileName = argv[1];
     std::vector<std::string> pos, neg;
     if (!rei::readFile(fileName, pos, neg)) return 0;
 
-    unsigned short costFun[5];
-    for (int i = 0; i < 5; i++)
-        costFun[i] = std::atoi(argv[i + 2]);
-    unsigned short maxCost = std::atoi(argv[7]);
-
     auto start = std::chrono::high_resolution_clock::now();
 
-    auto res = rei::Run(costFun, maxCost, pos, neg, 60 * 60 * 60);
+    rei::Solver solver(costFun, maxCost);
+    if (!checkpointPath.empty()) {
+        rei::CheckpointConfigs checkpoint;
+        checkpoint.path = checkpointPath;
+        solver.SetCheckpoint(checkpoint);
+    }
+
+    // one JSON object per line, a record for every phase and then the result
+    if (ndjson)
+        solver.SetStatsListener([](const rei::PhaseStats& stats) {
+            bool search = stats.phase == "bottom_up" || stats.phase == "top_down";
+            printf("{\"type\":\"phase\",\"phase\":\"%s\",\"level\":%d,\"time\":%f,\"generated\":%llu,\"stored\":%llu,\"load\":%f,\"rss\":%zu%s%s}\n",
+                stats.phase.c_str(), stats.level, stats.time, (unsigned long long)stats.generated, (unsigned long long)stats.stored, stats.load, stats.rss,
+                search ? ",\"detail\":" : "", search ? rei::toJson(stats.detail).c_str() : "");
+            fflush(stdout);
+        });
+
+    auto res = solver.Solve(pos, neg);
 
     auto stop = std::chrono::high_resolution_clock::now();
 
-    for (auto p : pos)
+    auto verification = rei::Verify(res.RE, pos, neg);
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
+
+    // the log records of the search are written before the result
+    LOG_FLUSH();
+
+    if (ndjson) {
+        auto name = std::filesystem::path(fileName).stem().string();
+        printf("{\"type\":\"result\",\"file\":\"%s\",\"RE\":\"%s\",\"cost\":%d,\"REs\":%llu,\"ICsize\":%d,\"time\":%f,\"unmatchedPos\":%zu,\"matchedNeg\":%zu,\"rss\":%zu,\"bottomUp\":%s,\"topDown\":%s}\n",
+            rei::escapeJson(name).c_str(), rei::escapeJson(res.RE).c_str(), rei::calculateCost(res.RE, costFun), (unsigned long long)res.allCS, res.ICsize,
+            (double)duration * 0.000001, verification.unmatchedPos.size(), verification.matchedNeg.size(), rei::residentBytes(),
+            rei::toJson(rei::SearchStats::Total(res.stats.bottomUp)).c_str(), rei::toJson(rei::SearchStats::Total(res.stats.topDown)).c_str());
+        return 0;
+    }
+
+    for (auto& p : verification.unmatchedPos)
     {
-        if (!match(res.RE, p))
-        {
-            printf("regex didn't match %s\n",p.c_str());
-        }
+        printf("regex didn't match %s\n",p.c_str());
     }
 
-    for (auto n : neg)
+    for (auto& n : verification.matchedNeg)
     {
-        if (match(res.RE, n))
-        {
-            printf("regex did match %s\n",n.c_str());
-        }
+        printf("regex did match %s\n",n.c_str());
     }
 
     printf("\n\nRE: \"%s\"\n", res.RE.c_str());
-    printf("Cost: %lu\n", calculateCost(res.RE, costFun));
+    printf("Cost: %lu\n", rei::calculateCost(res.RE, costFun));
     printf("REs: %llu\n", res.allCS);
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count();
     printf("\nRunning Time: %f s\n", (double)duration * 0.000001);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -189,6 +189,10 @@ Pair<CS> powerset_element(std::vector<Pair<CS>> pairs, int index) {
 }
 
 std::string rei::to_string(Operation op) {
+    return shortName(op);
+}
+
+const char* rei::shortName(Operation op) {
     switch (op)
     {
     case Operation::Question:
@@ -206,7 +210,7 @@ std::string rei::to_string(Operation op) {
 }
 
 std::vector<CS> rei::revertQuestion(const CS& cs) {
-    if (cs & CS::one())
+    if (cs.test(0))
         return std::vector<CS>{ cs | CS::one() };
     else
         return std::vector<CS>{};
@@ -214,43 +218,37 @@ std::vector<CS> rei::revertQuestion(const CS& cs) {
 
 // ========= Star =========
 
-std::vector<CS> rei::revertStarRandom(const CS& cs, size_t maxSamples, const GuideTable& guideTable, uint64_t seed) {
+// the words of cs that can not be built from two shorter words of cs, every star that produces cs contains them
+CS starBase(const CS& cs, const rei::GuideTable& guideTable) {
 
     auto baseCS = CS();
 
-    for (int i = 1; i < guideTable.ICsize; i++)
-    {
-        if (!((CS::one() << i) & cs))
-            continue;
-
-        bool exists = false;
+    cs.forEachSetBit([&](int i) {
+        if (i == 0) return;
 
         for (auto const& pair : guideTable.IterateRow(i))
-        {
-            if (((CS::one() << pair.left) & cs) && ((CS::one() << pair.right) & cs))
-            {
-                exists = true;
-                break;
-            }
-        }
+            if (cs.test(pair.left) && cs.test(pair.right)) return;
 
-        if (!exists)
-            baseCS |= (CS::one() << i);
-    }
+        baseCS.set(i);
+    }, guideTable.Words());
+
+    return baseCS;
+}
+
+std::vector<CS> rei::revertStarRandom(const CS& cs, size_t maxSamples, const GuideTable& guideTable, uint64_t seed) {
+
+    auto baseCS = starBase(cs, guideTable);
 
     if (processStar(guideTable, baseCS) != cs)
         return {};
 
-    std::vector<CS> res;
-
-    auto bits = getBits(baseCS ^ cs, guideTable.ICsize);
-    const auto bitsCount = bits.size();
+    SubsetEnumerator subsets(baseCS ^ cs, guideTable.Words());
+    const auto bitsCount = subsets.Count();
 
     if (bitsCount < 64 && (1ULL << bitsCount) <= maxSamples)
         return revertStar(cs, guideTable);
 
     std::mt19937_64 rng(seed);
-    std::bernoulli_distribution coin(0.5);
 
     std::vector<CS> result;
     result.reserve(maxSamples);
@@ -259,7 +257,7 @@ std::vector<CS> rei::revertStarRandom(const CS& cs, size_t maxSamples, const Gui
 
     while (result.size() < maxSamples) {
 
-        CS submask = getRandom(bits, rng, coin) | baseCS;
+        CS submask = subsets.Random(rng, baseCS);
 
         if (submask == cs) continue;
 
@@ -272,49 +270,27 @@ std::vector<CS> rei::revertStarRandom(const CS& cs, size_t maxSamples, const Gui
 
 std::vector<CS> rei::revertStar(const CS& cs, const GuideTable& guideTable) {
 
-    auto baseCS = CS();
-
-    for (int i = 1; i < guideTable.ICsize; i++)
-    {
-        if (!((CS::one() << i) & cs))
-            continue;
-
-        bool exists = false;
-
-        for (auto const& pair : guideTable.IterateRow(i))
-        {
-            if (((CS::one() << pair.left) & cs) && ((CS::one() << pair.right) & cs))
-            {
-                exists = true;
-                break;
-            }
-        }
-        
-        if (!exists)
-            baseCS |= (CS::one() << i);
-    }
+    auto baseCS = starBase(cs, guideTable);
 
     if (processStar(guideTable, baseCS) != cs)
         return {};
 
     std::vector<CS> res;
 
-    auto bits = getBits(baseCS ^ cs, guideTable.ICsize);
-    const auto bitsCount = bits.size();
-    const auto count = 1UL << bitsCount;
+    SubsetEnumerator subsets(baseCS ^ cs, guideTable.Words());
 
-    if (bitsCount > 64)
+    if (subsets.Count() >= 64)
     {
-        printf("revert Star can't handle a CS with more than 64 toggled bits!\n");
+        printf("revert Star can't handle a CS with 64 or more toggled bits!\n");
         return {};
     }
 
-    for (int i = 0; i < count; i++)
+    auto c = baseCS;
+    for (uint64_t i = 0; i <= subsets.Full(); i++)
     {
-        auto c = baseCS;
-        powerset_element(bitsCount, i, [&c, &bits](int index) { c |= (CS::one() << bits[index]); });
         if(c != cs)
             res.push_back(c);
+        subsets.Next(c);
     }
 
     return res;
@@ -375,13 +351,11 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
     vector<vector<Pair<int>>> sourcePairs;
     sourcePairs.reserve(guideTable.ICsize);
 
-    if (cs & CS::one())
+    if (cs.test(0))
         sourcePairs.push_back({ {0, 0} });
 
-    for (int i = 1; i < guideTable.ICsize; i++)
-    {
-        if (!((CS::one() << i) & cs))
-            continue;
+    cs.forEachSetBit([&](int i) {
+        if (i == 0) return;
 
         vector<Pair<int>> row;
 
@@ -389,10 +363,10 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
         row.emplace_back(i, 0);
 
         for (auto const& pair : guideTable.IterateRow(i))
-            row.push_back(pair);
+            row.emplace_back(pair.left, pair.right);
 
         sourcePairs.push_back(row);
-    }
+    }, guideTable.Words());
 
     if (sourcePairs.empty())
         return {};
@@ -404,17 +378,17 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
 
         auto pairMatch = [](const GuideTable& guideTable, const CS& cs, const rei::Pair<int>& a, const rei::Pair<int>& b) {
 
-            auto adj = guideTable.adjacencyList[a.left];
+            auto adj = guideTable.IterateAdjacency(a.left);
             for (int i = 0; i < adj.size(); i++)
             {
-                if (adj[i].first == b.right && !(cs & (CS::one() << adj[i].second)))
+                if (adj[i].right == b.right && !cs.test(adj[i].result))
                     return false;
             }
 
-            adj = guideTable.adjacencyList[b.left];
+            adj = guideTable.IterateAdjacency(b.left);
             for (int i = 0; i < adj.size(); i++)
             {
-                if (adj[i].first == a.right && !(cs & (CS::one() << adj[i].second)))
+                if (adj[i].right == a.right && !cs.test(adj[i].result))
                     return false;
             }
 
@@ -430,7 +404,7 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
             for (int j = 0; j < sourceRow.size(); j++)
             {
                 if (pairMatch(guideTable, cs, pair, sourceRow[j]))
-                    mask |= CS::one() << j;
+                    mask.set(j);
             }
             if (!mask)
                 return masks;
@@ -509,7 +483,7 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
 
             for (int j = 0; j < row.size(); j++)
             {
-                if (pickmask & (CS::one() << j))
+                if (pickmask.test(j))
                 {
                     ratio.push_back(i == sourcePairs.size() - 1 ? 1 : ratios[i][j]);
                 }
@@ -522,8 +496,8 @@ std::vector<Pair<CS>> rei::revertConcatRandom(const CS& cs, size_t maxSamples, c
 
             std::discrete_distribution<> dist(ratio.begin(), ratio.end());
             int sampled_index = dist(gen);
-            rPair.left |= CS::one() << row[sampled_index].left;
-            rPair.right |= CS::one() << row[sampled_index].right;
+            rPair.left.set(row[sampled_index].left);
+            rPair.right.set(row[sampled_index].right);
 
             if (i == sourcePairs.size() - 1)
             {
@@ -555,13 +529,11 @@ void revertConcatPrimary(const CS& cs, const rei::GuideTable& guideTable, std::v
     vector<vector<Pair<int>>> sourcePairs;
     sourcePairs.reserve(guideTable.ICsize);
 
-    if (cs & CS::one())
+    if (cs.test(0))
         sourcePairs.push_back({ {0, 0} });
 
-    for (int i = 1; i < guideTable.ICsize; i++)
-    {
-        if (!((CS::one() << i) & cs))
-            continue;
+    cs.forEachSetBit([&](int i) {
+        if (i == 0) return;
 
         vector<Pair<int>> row;
 
@@ -569,10 +541,10 @@ void revertConcatPrimary(const CS& cs, const rei::GuideTable& guideTable, std::v
         row.emplace_back(i , 0);
 
         for (auto const& pair : guideTable.IterateRow(i))
-            row.push_back(pair);
+            row.emplace_back(pair.left, pair.right);
 
         sourcePairs.push_back(row);
-    }
+    }, guideTable.Words());
 
     if (sourcePairs.empty())
         return;
@@ -583,11 +555,13 @@ void revertConcatPrimary(const CS& cs, const rei::GuideTable& guideTable, std::v
 
         auto p = sourcePairs[depth][element];
 
-        Pair<CS> next(pair.left | (CS::one() << p.left), pair.right | (CS::one() << p.right));
+        Pair<CS> next(pair);
+        next.left.set(p.left);
+        next.right.set(p.right);
 
         auto con = rei::processConcatenate(guideTable, next.left, next.right);
 
-        return std::pair<bool,Pair<CS>>( !(con & ~cs), next );
+        return std::pair<bool,Pair<CS>>( con.isSubsetOf(cs, guideTable.Words()), next );
     },
     [&result](Pair<CS> pair){ 
         result.push_back(pair); 
@@ -598,17 +572,13 @@ void revertConcatSecondary(const Pair<CS>& pair, const CS& cs, const rei::GuideT
 
     auto rightMask = CS(); // bits that we should not set
 
-    for (int i = 0; i < guideTable.ICsize; i++)
-    {
-        if ((CS::one() << i) & pair.left) {
-            auto adj = guideTable.adjacencyList[i];
-            for (size_t j = 0; j < adj.size(); j++)
-            {
-                if (!((CS::one() << adj[j].second) & cs))
-                    rightMask |= CS::one() << adj[j].first;
-            }
+    pair.left.forEachSetBit([&](int i) {
+        for (auto [right, result] : guideTable.IterateAdjacency(i))
+        {
+            if (!cs.test(result))
+                rightMask.set(right);
         }
-    }
+    }, guideTable.Words());
 
     depth_traversal<Pair<CS>>(guideTable.ICsize, Pair<CS>(pair.left, rightMask), [](int i) { return 2; },
         [&pair, &guideTable, &cs](int depth, int elemnet, Pair<CS> mask) {
@@ -617,22 +587,22 @@ void revertConcatSecondary(const Pair<CS>& pair, const CS& cs, const rei::GuideT
 
             if (elemnet == 1) {
 
-                if ((CS::one() << depth) & pair.left) // already been set
+                if (pair.left.test(depth)) // already been set
                     return std::pair<bool, Pair<CS>>(false, mask);
 
-                next.left |= CS::one() << depth;
+                next.left.set(depth);
 
-                auto adj = guideTable.adjacencyList[depth];
+                auto adj = guideTable.IterateAdjacency(depth);
 
                 for (int i = 0; i < adj.size(); i++)
                 {
-                    if (!((CS::one() << adj[i].second) & cs)) {
+                    if (!cs.test(adj[i].result)) {
                         // check if the current left word combined with the existing words on 
                         // the right will produce word that is not included in the target
-                        if ((CS::one() << adj[i].first & pair.right))
+                        if (pair.right.test(adj[i].right))
                             return std::pair<bool, Pair<CS>>(false, mask);
                         else
-                            next.right |= CS::one() << adj[i].first;
+                            next.right.set(adj[i].right);
                     }
                 }
             }
@@ -643,28 +613,15 @@ void revertConcatSecondary(const Pair<CS>& pair, const CS& cs, const rei::GuideT
 
             const auto combined = pair.right | mask.right;
 
-            std::vector<int> bits;
-            for (int i = 0; i < guideTable.ICsize; i++)
-            {
-                auto cs = (CS::one() << i);
-                if (!(cs & combined))
-                    bits.push_back(i);
-            }
+            CS free = rei::firstBits(guideTable.ICsize);
+            free.andNotAssign(combined, guideTable.Words());
+            rei::SubsetEnumerator subsets(free, guideTable.Words());
 
-            const size_t numBits = bits.size();
-            const size_t numCombinations = 1ull << numBits;
+            const size_t numCombinations = 1ull << subsets.Count();
 
-            for (size_t subset = 0; subset < numCombinations; ++subset)
+            CS combination = pair.right;
+            for (size_t subset = 0; subset < numCombinations; ++subset, subsets.Next(combination))
             {
-                CS combination = pair.right;
-
-                for (size_t bit = 0; bit < numBits; ++bit)
-                {
-                    if (subset & (1ull << bit))
-                    {
-                        combination |= (CS::one() << bits[bit]);
-                    }
-                }
 
                 if(mask.left != CS::one() && combination != CS::one())
                     result.push_back({ mask.left, combination });
@@ -700,10 +657,9 @@ std::vector<Pair<CS>> rei::revertOrRandom(const CS& cs, size_t maxSamples, int I
     if (popCount < 64 && (1ULL << (popCount - 1)) <= maxSamples)
         return revertOr(cs);
 
-    std::vector<int> bits = getBits(cs, ICsize);
+    SubsetEnumerator subsets(cs, CS::wordsFor(ICsize));
 
     std::mt19937_64 rng(seed);
-    std::bernoulli_distribution coin(0.5);
 
     std::vector<Pair<CS>> result;
     result.reserve(maxSamples);
@@ -712,7 +668,7 @@ std::vector<Pair<CS>> rei::revertOrRandom(const CS& cs, size_t maxSamples, int I
 
     while (result.size() < maxSamples) {
 
-        CS submask = getRandom(bits, rng, coin);
+        CS submask = subsets.Random(rng);
 
         if (!submask) continue;
         if (submask == cs) continue;
@@ -728,7 +684,8 @@ std::vector<Pair<CS>> rei::revertOrRandom(const CS& cs, size_t maxSamples, int I
 
 vector<Pair<CS>> rei::revertOr(const CS& cs) {
 
-    const auto popCount = cs.popCount();
+    SubsetEnumerator subsets(cs);
+    const auto popCount = subsets.Count();
 
     if (popCount > 64)
     {
@@ -736,31 +693,31 @@ vector<Pair<CS>> rei::revertOr(const CS& cs) {
         return {};
     }
 
-    CS submask = cs;
+    // every counter below Full() is a submask, so the walk only needs a decrement
+    uint64_t start = subsets.Full();
 
     auto count = 1ULL << (popCount - 1);
 
     // remove the pair that contains zero or one
     count--;
-    submask--;
-    submask = submask & cs;
+    start--;
 
-    if (cs & CS::one()) 
+    // eps is the lowest set bit, bit 0 of the counter
+    if (cs.test(0))
     {
         count--;
-        submask--;
-        submask = submask & cs;
+        start--;
     }
 
+    CS submask = subsets.Expand(start);
+
     vector<Pair<CS>> pairs;
     pairs.reserve(count);
 
     for (size_t i = 0; i < count; i++)
     {
-        CS complement = cs ^ submask;
-        pairs.emplace_back(submask, complement);
-        submask--;
-        submask = submask & cs;
+        pairs.emplace_back(submask, cs ^ submask);
+        subsets.Previous(submask);
     }
 
     return pairs;
@@ -1,48 +1,33 @@
 #include "regex_match.hpp"
 
- Char::Char(char c) : c(c) {}
- bool Char::match(const string& word) const {
-    return word.size() == 1 && word[0] == c;
-}
-
- Or::Or(shared_ptr<Regex> l, shared_ptr<Regex> r) : left(l), right(r) {}
- bool Or::match(const string& word) const {
-    return left->match(word) || right->match(word);
-}
+#include <bit>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
 
- And::And(shared_ptr<Regex> l, shared_ptr<Regex> r) : left(l), right(r) {}
- bool And::match(const string& word) const {
-    return left->match(word) && right->match(word);
-}
-
- Star::Star(shared_ptr<Regex> n) : node(n) {}
- bool Star::match(const string& word) const {
-    if (word.empty()) return true;
-    for (size_t i = 1; i <= word.size(); ++i) {
-        string prefix = word.substr(0, i);
-        string suffix = word.substr(i);
-        if (node->match(prefix)) {
-            if (suffix.empty() || this->match(suffix)) {
+bool RegexTree::Backtrack(int node, std::string_view word) const {
+    const RegexNode& n = nodes[node];
+    switch (n.tag) {
+    case RegexTag::Char:
+        return word.size() == 1 && word[0] == n.c;
+    case RegexTag::Or:
+        return Backtrack(n.left, word) || Backtrack(n.right, word);
+    case RegexTag::And:
+        return Backtrack(n.left, word) && Backtrack(n.right, word);
+    case RegexTag::Optional:
+        return word.empty() || Backtrack(n.left, word);
+    case RegexTag::Star:
+        if (word.empty()) return true;
+        for (size_t i = 1; i <= word.size(); ++i)
+            if (Backtrack(n.left, word.substr(0, i)) && Backtrack(node, word.substr(i)))
                 return true;
-            }
-        }
-    }
-    return false;
-}
-
- Optional::Optional(shared_ptr<Regex> n) : node(n) {}
- bool Optional::match(const string& word) const {
-    return word.empty() || node->match(word);
-}
-
- Concat::Concat(shared_ptr<Regex> l, shared_ptr<Regex> r) : left(l), right(r) {}
- bool Concat::match(const string& word) const {
-    for (size_t i = 0; i <= word.size(); ++i) {
-        string leftPart = word.substr(0, i);
-        string rightPart = word.substr(i);
-        if (left->match(leftPart) && right->match(rightPart)) {
-            return true;
-        }
+        return false;
+    case RegexTag::Concat:
+        for (size_t i = 0; i <= word.size(); ++i)
+            if (Backtrack(n.left, word.substr(0, i)) && Backtrack(n.right, word.substr(i)))
+                return true;
+        return false;
     }
     return false;
 }
@@ -57,87 +42,411 @@
     return regex[pos++];
 }
 
- shared_ptr<Regex> Parser::parse() {
-     return parseOr();
+ // a pattern has at most one node per character
+ RegexTree Parser::parse() {
+     tree = RegexTree();
+     tree.Reserve(regex.size());
+     parseOr();
+     return std::move(tree);
  }
 
- shared_ptr<Regex> Parser::parseOr() {
-    shared_ptr<Regex> node = parseIntersection();
+ int Parser::parseOr() {
+    int node = parseIntersection();
     while (peek() == '+') {
         get();
-        shared_ptr<Regex> right = parseIntersection();
-        node = make_shared<Or>(node, right);
+        int right = parseIntersection();
+        node = tree.Add(RegexTag::Or, node, right);
     }
     return node;
 }
 
- shared_ptr<Regex> Parser::parseIntersection() {
-    shared_ptr<Regex> node = parseConcat();
+ int Parser::parseIntersection() {
+    int node = parseConcat();
     while (peek() == '&') {
         get();
-        shared_ptr<Regex> right = parseConcat();
-        node = make_shared<And>(node, right);
+        int right = parseConcat();
+        node = tree.Add(RegexTag::And, node, right);
     }
     return node;
 }
 
- shared_ptr<Regex> Parser::parseConcat() {
-    shared_ptr<Regex> node = parseFactor();
+ int Parser::parseConcat() {
+    int node = parseFactor();
     while (true) {
         char c = peek();
         if (c == '\0' || c == ')' || c == '+' || c == '&') break;
-        shared_ptr<Regex> next = parseFactor();
-        node = make_shared<Concat>(node, next);
+        int next = parseFactor();
+        node = tree.Add(RegexTag::Concat, node, next);
     }
     return node;
 }
 
- shared_ptr<Regex> Parser::parseFactor() {
-    shared_ptr<Regex> node = parseBase();
+ int Parser::parseFactor() {
+    int node = parseBase();
     while (peek() == '*' || peek() == '?') {
         char op = get();
-        if (op == '*') node = make_shared<Star>(node);
-        else if (op == '?') node = make_shared<Optional>(node);
+        if (op == '*') node = tree.Add(RegexTag::Star, node);
+        else if (op == '?') node = tree.Add(RegexTag::Optional, node);
     }
     return node;
 }
 
- shared_ptr<Regex> Parser::parseBase() {
+ int Parser::parseBase() {
     if (peek() == '(') {
         get();
-        shared_ptr<Regex> node = parseOr();
+        int node = parseOr();
         if (get() != ')') throw runtime_error("Missing ')'");
         return node;
     }
     else {
         char c = get();
-        return make_shared<Char>(c);
+        return tree.Add(RegexTag::Char, -1, -1, c);
+    }
+}
+
+// the sorted words share their prefix with the word before them, so the trie is built along one path and
+// the nodes come out in depth-first order
+ExampleTrie::ExampleTrie(const vector<string>& words) : nodeOf(words.size()) {
+    vector<std::pair<std::string_view, int>> order(words.size());
+    size_t letters = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+        order[i] = { words[i], static_cast<int>(i) };
+        letters += words[i].size();
+    }
+    std::sort(order.begin(), order.end());
+
+    nodes.reserve(letters + 1);
+    nodes.push_back({ -1, 0, 0 });
+    vector<int> path = { 0 };
+    std::string_view previous;
+    for (auto [w, word] : order) {
+        size_t shared = 0, limit = std::min(previous.size(), w.size());
+        while (shared < limit && previous[shared] == w[shared]) shared++;
+        while (path.size() > shared + 1) {
+            nodes[path.back()].end = Size();
+            path.pop_back();
+        }
+        for (size_t i = shared; i < w.size(); i++) {
+            nodes.push_back({ path.back(), 0, w[i] });
+            path.push_back(Size() - 1);
+        }
+        nodeOf[word] = path.back();
+        previous = w;
+    }
+    for (int node : path) nodes[node].end = Size();
+    nodes.shrink_to_fit();
+}
+
+// a subpattern is the range of nodes that ends at its root, the size is found from its first operand
+int subtreeStart(const RegexTree& tree, int node) {
+    while (tree[node].left >= 0) node = tree[node].left;
+    return node;
+}
+
+bool containsAnd(const RegexTree& tree, int root) {
+    for (int i = subtreeStart(tree, root); i <= root; i++)
+        if (tree[i].tag == RegexTag::And) return true;
+    return false;
+}
+
+RegexMatcher::Automaton::Automaton(const RegexTree& tree, int root, size_t dfaBytes) : dfaBytes(dfaBytes) {
+    int letterCount = 0;
+    if (root >= 0)
+        for (int i = subtreeStart(tree, root); i <= root; i++)
+            letterCount += tree[i].tag == RegexTag::Char;
+
+    words = (letterCount + 1 + 63) / 64;
+    follows.assign(static_cast<size_t>(letterCount) * words, 0);
+    letters.assign(256 * static_cast<size_t>(words), 0);
+
+    Node automaton = build(tree, root);
+    nullable = automaton.nullable;
+    first = std::move(automaton.first);
+    last = std::move(automaton.last);
+
+    // the letters of the pattern have disjoint masks, every one of them is a class
+    classes = 1;
+    classLetter.assign(1, 0);
+    for (int c = 0; c < 256; c++) {
+        const uint64_t* mask = letters.data() + c * static_cast<size_t>(words);
+        classOf[c] = std::any_of(mask, mask + words, [](uint64_t w) { return w != 0; }) ? classes++ : 0;
+        if (classOf[c]) classLetter.push_back(static_cast<unsigned char>(c));
+    }
+
+    scratch.resize(words);
+    reset();
+}
+
+// the first and last positions of every subpattern, the concatenations and the stars link the last
+// positions of one part to the first positions of the next
+RegexMatcher::Automaton::Node RegexMatcher::Automaton::build(const RegexTree& tree, int node) {
+
+    auto orInto = [this](vector<uint64_t>& to, const uint64_t* from) {
+        for (int i = 0; i < words; i++) to[i] |= from[i];
+    };
+    auto link = [this, &orInto](const vector<uint64_t>& from, const vector<uint64_t>& to) {
+        for (int w = 0; w < words; w++)
+            for (uint64_t bits = from[w]; bits; bits &= bits - 1) {
+                uint64_t* f = follow(w * 64 + std::countr_zero(bits));
+                for (int i = 0; i < words; i++) f[i] |= to[i];
+            }
+    };
+
+    if (node < 0) return { true, vector<uint64_t>(words), vector<uint64_t>(words) };
+
+    const RegexNode& n = tree[node];
+    switch (n.tag) {
+    case RegexTag::Char: {
+        Node res{ false, vector<uint64_t>(words), vector<uint64_t>(words) };
+        int position = positions++;
+        res.first[position >> 6] = res.last[position >> 6] = uint64_t(1) << (position & 63);
+        letters[static_cast<unsigned char>(n.c) * static_cast<size_t>(words) + (position >> 6)] |= uint64_t(1) << (position & 63);
+        return res;
+    }
+    case RegexTag::Or: {
+        Node left = build(tree, n.left), right = build(tree, n.right);
+        orInto(left.first, right.first.data());
+        orInto(left.last, right.last.data());
+        left.nullable |= right.nullable;
+        return left;
+    }
+    case RegexTag::Concat: {
+        Node left = build(tree, n.left), right = build(tree, n.right);
+        link(left.last, right.first);
+        Node res{ left.nullable && right.nullable, left.first, right.last };
+        if (left.nullable) orInto(res.first, right.first.data());
+        if (right.nullable) orInto(res.last, left.last.data());
+        return res;
+    }
+    case RegexTag::Star: {
+        Node res = build(tree, n.left);
+        link(res.last, res.first);
+        res.nullable = true;
+        return res;
+    }
+    case RegexTag::Optional: {
+        Node res = build(tree, n.left);
+        res.nullable = true;
+        return res;
+    }
+    default:
+        throw runtime_error("'&' can only be compiled at the top of a pattern");
+    }
+}
+
+// the DFA with only the dead state and the start state
+void RegexMatcher::Automaton::reset() const {
+    sets.clear();
+    transitions.clear();
+    accepting.clear();
+    index.clear();
+
+    vector<uint64_t> set(words, 0);
+    intern(set.data());
+    set[positions >> 6] |= uint64_t(1) << (positions & 63);
+    intern(set.data());
+}
+
+int RegexMatcher::Automaton::intern(const uint64_t* set) const {
+    string key(reinterpret_cast<const char*>(set), words * sizeof(uint64_t));
+    auto [it, inserted] = index.emplace(std::move(key), static_cast<int>(accepting.size()));
+    if (!inserted) return it->second;
+
+    bool accepts = (set[positions >> 6] >> (positions & 63) & 1) && nullable;
+    for (int i = 0; i < words; i++) accepts |= (set[i] & last[i]) != 0;
+
+    sets.insert(sets.end(), set, set + words);
+    accepting.push_back(accepts);
+    transitions.resize(transitions.size() + classes, -1);
+    // a letter that is not in the pattern ends every match
+    transitions[transitions.size() - classes] = Dead;
+    return it->second;
+}
+
+int RegexMatcher::Automaton::step(int state, int letterClass) const {
+
+    // the follows of the active positions, and the first positions from the start
+    const uint64_t* set = sets.data() + static_cast<size_t>(state) * words;
+    std::fill(scratch.begin(), scratch.end(), 0);
+    if (set[positions >> 6] >> (positions & 63) & 1)
+        for (int i = 0; i < words; i++) scratch[i] = first[i];
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = set[w];
+        if (w == positions >> 6) bits &= ~(uint64_t(1) << (positions & 63));
+        for (; bits; bits &= bits - 1) {
+            const uint64_t* f = follow(w * 64 + std::countr_zero(bits));
+            for (int i = 0; i < words; i++) scratch[i] |= f[i];
+        }
+    }
+
+    const uint64_t* mask = letters.data() + classLetter[letterClass] * static_cast<size_t>(words);
+    for (int i = 0; i < words; i++) scratch[i] &= mask[i];
+
+    // a state takes its set twice (the table and the key), its transitions and the node of the key
+    size_t stateBytes = 2 * words * sizeof(uint64_t) + classes * sizeof(int) + 64;
+    if ((accepting.size() + 1) * stateBytes > dfaBytes && accepting.size() > 2) {
+        flushes++;
+        reset();
+        return intern(scratch.data());
+    }
+
+    int next = intern(scratch.data());
+    transitions[static_cast<size_t>(state) * classes + letterClass] = next;
+    return next;
+}
+
+bool RegexMatcher::Automaton::Match(const string& word) const {
+    int state = Start;
+    for (char letter : word) {
+        int letterClass = classOf[static_cast<unsigned char>(letter)];
+        int next = transitions[static_cast<size_t>(state) * classes + letterClass];
+        if (next < 0) next = step(state, letterClass);
+        if (next == Dead) return false;
+        state = next;
+    }
+    return accepting[state];
+}
+
+void RegexMatcher::Automaton::Match(const ExampleTrie& trie, int begin, int end, char* accepted) const {
+    vector<int> states(end - begin);
+    vector<size_t> stamps(end - begin, SIZE_MAX);
+    vector<int> path;
+
+    // the state of a node is kept until the DFA is dropped, then it is found again from the nearest node that
+    // still has one, which is also how a range finds the state of its first parent
+    auto stateOf = [&](int node) {
+        while (node > 0 && !(node >= begin && node < end && stamps[node - begin] == flushes)) {
+            path.push_back(node);
+            node = trie[node].parent;
+        }
+        int state = node > 0 ? states[node - begin] : Start;
+        for (; !path.empty(); path.pop_back()) {
+            if (state != Dead) state = next(state, trie[path.back()].letter);
+        }
+        return state;
+    };
+
+    for (int node = begin; node < end;) {
+        int state = node == 0 ? Start : stateOf(trie[node].parent);
+        if (node > 0 && state != Dead) state = next(state, trie[node].letter);
+
+        // no word below a dead state matches
+        if (state == Dead) {
+            int subtreeEnd = std::min(trie[node].end, end);
+            std::fill(accepted + (node - begin), accepted + (subtreeEnd - begin), 0);
+            node = subtreeEnd;
+            continue;
+        }
+        states[node - begin] = state;
+        stamps[node - begin] = flushes;
+        accepted[node - begin] = accepting[state];
+        node++;
+    }
+}
+
+RegexMatcher::RegexMatcher(const string& pattern, size_t dfaBytes) {
+
+    RegexTree tree;
+    if (pattern != "eps") {
+        Parser parser(pattern);
+        tree = parser.parse();
+    }
+
+    // a word matches an intersection when it matches both operands
+    vector<int> operands = { tree.Root() };
+    while (!operands.empty()) {
+        int node = operands.back();
+        operands.pop_back();
+        if (node >= 0 && tree[node].tag == RegexTag::And) {
+            operands.push_back(tree[node].left);
+            operands.push_back(tree[node].right);
+        }
+        else if (node >= 0 && containsAnd(tree, node)) {
+            conjuncts.clear();
+            fallback = std::move(tree);
+            backtrack = true;
+            return;
+        }
+        else conjuncts.emplace_back(tree, node, dfaBytes);
+    }
+}
+
+bool RegexMatcher::Match(const string& word) const {
+    if (backtrack) return fallback.Backtrack(fallback.Root(), word);
+    for (auto& automaton : conjuncts)
+        if (!automaton.Match(word)) return false;
+    return true;
+}
+
+vector<bool> RegexMatcher::Match(const ExampleTrie& trie) const {
+    // below this the threads cost more than they save
+    const int parallelNodes = 1 << 15;
+
+    if (backtrack) {
+        vector<bool> matched(trie.Words());
+        string word;
+        for (int k = 0; k < trie.Words(); k++) {
+            word.clear();
+            for (int node = trie.NodeOf(k); node > 0; node = trie[node].parent) word += trie[node].letter;
+            std::reverse(word.begin(), word.end());
+            matched[k] = fallback.Backtrack(fallback.Root(), word);
+        }
+        return matched;
     }
+
+    int threads = trie.Size() < parallelNodes ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    int chunk = threads == 1 ? trie.Size() : 1 << 12;
+
+    // vector<bool> packs its bits, the workers write whole bytes
+    vector<char> accepted(trie.Size());
+
+    std::atomic<int> next = 0;
+    auto worker = [&](const RegexMatcher& matcher) {
+        vector<char> conjunct;
+        for (int start = next.fetch_add(chunk); start < trie.Size(); start = next.fetch_add(chunk)) {
+            int end = std::min(start + chunk, trie.Size());
+            char* out = accepted.data() + start;
+            std::fill(out, out + (end - start), 1);
+            conjunct.resize(end - start);
+            for (auto& automaton : matcher.conjuncts) {
+                automaton.Match(trie, start, end, conjunct.data());
+                for (int i = 0; i < end - start; i++) out[i] &= conjunct[i];
+            }
+        }
+    };
+
+    // every thread but this one builds its DFA in a copy
+    vector<RegexMatcher> copies(threads - 1, *this);
+    vector<std::thread> pool;
+    for (auto& copy : copies)
+        pool.emplace_back(worker, std::cref(copy));
+    worker(*this);
+
+    for (auto& t : pool) t.join();
+
+    vector<bool> matched(trie.Words());
+    for (int k = 0; k < trie.Words(); k++) matched[k] = accepted[trie.NodeOf(k)];
+    return matched;
+}
+
+size_t RegexMatcher::States() const {
+    size_t states = 0;
+    for (auto& automaton : conjuncts) states += automaton.States();
+    return states;
+}
+
+size_t RegexMatcher::Flushes() const {
+    size_t flushes = 0;
+    for (auto& automaton : conjuncts) flushes += automaton.Flushes();
+    return flushes;
 }
 
  bool match(const string& pattern, const string& word) {
-    Parser parser(pattern);
-    shared_ptr<Regex> tree = parser.parse();
-    return tree->match(word);
+    return RegexMatcher(pattern).Match(word);
 }
 
  vector<bool> match(const vector<string>& examples, const string& pattern)
  {
-     vector<bool> res(examples.size());
-
-     if (pattern != "eps")
-     {
-         Parser parser(pattern);
-         shared_ptr<Regex> tree = parser.parse();
-
-         for (int i = 0; i < examples.size(); i++)
-             res[i] = tree->match(examples[i]);
-     }
-     else
-     {
-         for (int i = 0; i < examples.size(); i++)
-             res[i] = examples[i].empty();
-     }
-
-     return res;
- }
\ No newline at end of file
+     return RegexMatcher(pattern).Match(ExampleTrie(examples));
+ }
@@ -2,14 +2,56 @@
 
 #include <span>
 #include <queue>
+#include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
+#include <stdexcept>
+#include <chrono>
 
 #include <bottom_up.hpp>
 #include <top_down.hpp>
+#include <search_arena.hpp>
+#include <checkpoint.hpp>
+#include <guide_table_cache.hpp>
+#include <regex_match.hpp>
+#include <util.hpp>
+#include <logger.hpp>
 
 using namespace rei;
 
+// hands the stats of a phase to the listener of the solver and to the info log, a phase lasts from the previous report
+class PhaseReporter
+{
+public:
+    PhaseReporter(const StatsListener& listener) : listener(listener), last(std::chrono::steady_clock::now()) { }
+
+    void Report(const char* phase, int level, uint64_t generated, uint64_t stored, double load, const LevelStats& detail = LevelStats()) {
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - last).count();
+        LOG_INFO("%-11s | Level %-2d | Time: %-10.6f | Generated: %-11llu | Stored: %-10llu | Load: %.3f \n",
+            phase, level, time, static_cast<unsigned long long>(generated), static_cast<unsigned long long>(stored), load);
+
+        if (listener) {
+            PhaseStats stats;
+            stats.phase = phase;
+            stats.level = level;
+            stats.time = time;
+            stats.generated = generated;
+            stats.stored = stored;
+            stats.load = load;
+            stats.rss = residentBytes();
+            stats.detail = detail;
+            listener(stats);
+        }
+
+        // the listener is not timed as part of the next phase
+        last = std::chrono::steady_clock::now();
+    }
+
+private:
+    const StatsListener& listener;
+    std::chrono::steady_clock::time_point last;
+};
+
 class AlphabetResolver : public CSResolverInterface
 {
 public:
@@ -43,11 +85,16 @@ private:
 };
 
 Result RunBottomUp(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs, 
-    const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity) {
+    const unsigned short maxCost, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena) {
 
     BottomUpSearchResult buRes = {};
 
-    BottomUpSearch bottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, cache_capacity);
+    SearchLimits limits;
+    limits.buCacheCapacity = cache_capacity;
+    limits.tdCacheCapacity = 0;
+    arena.Reserve(limits);
+
+    BottomUpSearch bottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, cache_capacity, arena);
 
     EnumerationState enumState;
     do {
@@ -61,11 +108,16 @@ Result RunBottomUp(const GuideTable& guideTable, const std::set<char>& alphabets
 }
 
 Result RunTopDown(const GuideTable& guideTable, const std::set<char>& alphabets, const Costs& costs,
-    const unsigned short maxLevel, const CS& posBits, const CS& negBits, int cache_capacity, int samples = 16) {
+    const unsigned short maxLevel, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena, int samples = 16) {
 
     TopDownSearchResult tdRes = {};
 
-    TopDownSearch topDown(guideTable, std::make_shared<AlphabetResolver>(alphabets), maxLevel, posBits, negBits, cache_capacity);
+    SearchLimits limits;
+    limits.buCacheCapacity = 0;
+    limits.tdCacheCapacity = cache_capacity;
+    arena.Reserve(limits);
+
+    TopDownSearch topDown(guideTable, std::make_shared<AlphabetResolver>(alphabets), maxLevel, posBits, negBits, cache_capacity, arena);
 
     HeuristicConfigs heuristicConfigs;
     heuristicConfigs.EnableRandomSamplingForAll(samples);
@@ -87,73 +139,350 @@ Result RunTopDown(const GuideTable& guideTable, const std::set<char>& alphabets,
 }
 
 Result RunBidirectional(const GuideTable& guideTable, const std::set<char>& alphabets, 
-    const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits, int topDownsamples = 16) {
+    const Costs& costs, const unsigned short maxCost, const CS& posBits, const CS& negBits,
+    const SearchLimits& limits, SearchArena& arena, PhaseReporter& reporter, int topDownsamples = 16, Checkpoint* checkpoint = nullptr) {
+
+    arena.Reserve(limits);
 
     // Bottom-Up
-    int buCacheCapacity = 2000000;
     int levels = 13;
     BottomUpSearchResult buRes = {};
 
-    BottomUpSearch bottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, buCacheCapacity);
+    BottomUpSearch bottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, limits.buCacheCapacity, arena);
 
     // Top-Down
     int maxLevel = 50;
-    int tdCacheCapacity = 8000000;
     TopDownSearchResult tdRes = {};
 
-    TopDownSearch topDown(guideTable, std::make_shared<BottomUpResolver>(bottomUp), maxLevel, posBits, negBits, tdCacheCapacity);
+    TopDownSearch topDown(guideTable, std::make_shared<BottomUpResolver>(bottomUp), maxLevel, posBits, negBits, limits.tdCacheCapacity, arena);
 
     HeuristicConfigs heuristicConfigs;
     heuristicConfigs.EnableRandomSamplingForAll(topDownsamples);
     topDown.SetHeuristic(heuristicConfigs);
 
-    topDown.Push(CS::one(), tdRes);
-    for (int i = 0; i < alphabets.size(); i++)
-        topDown.Push(CS::one() << (i + 1), tdRes);
+    auto withStats = [&](Result res) {
+        res.stats.bottomUp = bottomUp.Stats();
+        res.stats.topDown = topDown.Stats();
+        return res;
+    };
+
+    auto phase = checkpoint ? checkpoint->Load(bottomUp, topDown) : CheckpointPhase::None;
+    buRes.allREs = bottomUp.AllREs();
+    reporter.Report("setup", 0, bottomUp.AllREs(), bottomUp.Stored(), bottomUp.VisitedLoad());
+
+    // the bottom-up languages (the alphabets included) are given to the top-down search once it starts,
+    // only eps is not stored by the bottom-up search. a restored top-down graph already holds it
+    if (phase != CheckpointPhase::TopDown)
+        topDown.Push(CS::one(), tdRes);
 
     // Search
-    EnumerationState enumState;
-    int i = 0;
-    do {
+    EnumerationState enumState = EnumerationState::NotFound;
+    int i = phase == CheckpointPhase::TopDown ? levels : bottomUp.ResumeLevel() - (costs.alpha + 1);
+    while (i++ < levels) {
+        auto generated = bottomUp.AllREs();
         enumState = bottomUp.EnumerateCostLevel(buRes);
+        // a level past the maximum cost ends the search without enumerating anything
+        if (enumState != EnumerationState::End || bottomUp.AllREs() != generated)
+            reporter.Report("bottom_up", buRes.cost, bottomUp.AllREs(), bottomUp.Stored(), bottomUp.VisitedLoad(), bottomUp.Stats().back());
         if (enumState != EnumerationState::NotFound) break;
-        auto plevel = bottomUp.GetLastCostLevel();
-        for (const auto& cs : plevel)
-            topDown.Push(cs, tdRes);
-    } while (++i < levels);
+        if (checkpoint && checkpoint->Due()) checkpoint->Save(bottomUp, nullptr);
+    }
 
     if (enumState == EnumerationState::Found)
-        return Result(buRes.RE, guideTable.ICsize, buRes.allREs);
+        return withStats(Result(buRes.RE, guideTable.ICsize, buRes.allREs));
+
+    // the bottom-up languages are only read from now on
+    bottomUp.Freeze();
+    topDown.SetGiven(bottomUp.Frozen());
+    reporter.Report("freeze", buRes.cost, bottomUp.AllREs(), bottomUp.Frozen().Size(), bottomUp.VisitedLoad());
 
     do {
+        auto generated = topDown.Candidates();
         enumState = topDown.EnumerateLevel(tdRes);
+        if (enumState != EnumerationState::End || topDown.Candidates() != generated)
+            reporter.Report("top_down", tdRes.level, topDown.Candidates(), tdRes.allCS, topDown.VisitedLoad(), topDown.Stats().back());
+        if (enumState == EnumerationState::NotFound && checkpoint && checkpoint->Due()) checkpoint->Save(bottomUp, &topDown);
     } while (enumState == EnumerationState::NotFound);
 
     if (enumState == EnumerationState::Found)
-        return Result(tdRes.RE, guideTable.ICsize, tdRes.allCS + buRes.allREs);
+        return withStats(Result(tdRes.RE, guideTable.ICsize, tdRes.allCS + buRes.allREs));
     else
-        return Result("not_found", guideTable.ICsize, tdRes.allCS + buRes.allREs);
+        return withStats(Result("not_found", guideTable.ICsize, tdRes.allCS + buRes.allREs));
 }
 
 rei::Result rei::Run(const unsigned short* costFun, const unsigned short maxCost,
-    const std::vector<std::string>& pos, const std::vector<std::string>& neg, double maxTime) {
+    const std::vector<std::string>& pos, const std::vector<std::string>& neg, double maxTime, bool selfCheck) {
+    Solver solver(costFun, maxCost);
+    solver.SetSelfCheck(selfCheck);
+    return solver.Solve(pos, neg);
+}
+
+rei::Verification rei::Verify(const std::string& RE, const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
+
+    Verification verification;
+
+    GuideTable guideTable;
+    CS posBits, negBits;
+    auto ic = generatingIC(pos, neg);
+
+    // an IC that does not fit in a CS is matched word by word
+    if (!generatingGuideTable(guideTable, posBits, negBits, ic, pos, neg)) {
+        RegexMatcher matcher(RE);
+        auto posMatched = matcher.Match(ExampleTrie(pos));
+        auto negMatched = matcher.Match(ExampleTrie(neg));
+        for (size_t i = 0; i < pos.size(); i++) if (!posMatched[i]) verification.unmatchedPos.push_back(pos[i]);
+        for (size_t i = 0; i < neg.size(); i++) if (negMatched[i]) verification.matchedNeg.push_back(neg[i]);
+        return verification;
+    }
+
+    CS language = languageOf(guideTable, findAlphabets(pos, neg), RE);
+
+    // the words are only looked up when the masks show a wrong one
+    if ((language & posBits) != posBits)
+        for (auto& p : pos) if (!language.test(indexOfWord(ic, p))) verification.unmatchedPos.push_back(p);
+    if (language & negBits)
+        for (auto& n : neg) if (language.test(indexOfWord(ic, n))) verification.matchedNeg.push_back(n);
+
+    return verification;
+}
+
+rei::Solver::Solver(const unsigned short* costFun, const unsigned short maxCost, const SearchLimits& limits) :
+    maxCost(maxCost), limits(limits), arena(std::make_unique<SearchArena>()) {
+    for (int i = 0; i < 5; i++)
+        this->costFun[i] = costFun[i];
+}
+
+rei::Solver::~Solver() = default;
+
+size_t rei::Solver::ArenaBytes() const {
+    return arena->Bytes();
+}
+
+void rei::Solver::SetCheckpoint(const CheckpointConfigs& configs) {
+    checkpoint = configs;
+}
+
+void rei::Solver::SetGuideTableCache(const std::string& directory) {
+    guideTableCache = directory.empty() ? nullptr : std::make_unique<GuideTableCache>(directory);
+}
+
+rei::Result rei::Solver::Solve(const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
 
     std::string RE;
 
     GuideTable guideTable;
     CS posBits, negBits;
+    std::set<char> alphabets;
 
-    if (!generatingGuideTable(guideTable, posBits, negBits, pos, neg))
-        return Result("not_found", 0, 0);
+    PhaseReporter reporter(statsListener);
+
+    if (guideTableCache) {
+        if (!guideTableCache->Get(guideTable, posBits, negBits, alphabets, pos, neg))
+            return Result("not_found", 0, 0);
+    }
+    else {
+        if (!generatingGuideTable(guideTable, posBits, negBits, pos, neg))
+            return Result("not_found", 0, 0);
+        alphabets = findAlphabets(pos, neg);
+    }
+
+    reporter.Report("guide_table", 0, 0, guideTable.ICsize, 0);
 
     Costs costs(costFun);
 
-    auto alphabets = findAlphabets(pos, neg);
-    if(intialCheck(alphabets, pos, RE)) return Result(RE, guideTable.ICsize, alphabets.size() + 2);
+    auto checked = [&](Result res) {
+        if (selfCheck && res.RE != "not_found") {
+            CS language = languageOf(guideTable, alphabets, res.RE);
+            if ((language & posBits) != posBits || (language & negBits))
+                throw std::logic_error("the search returned \"" + res.RE + "\", which does not separate the examples");
+        }
+        return res;
+    };
+
+    if(intialCheck(alphabets, pos, RE)) return checked(Result(RE, guideTable.ICsize, alphabets.size() + 2));
+
+    //return RunBottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, 20000000, *arena);
+
+    //return RunTopDown(guideTable, alphabets, costs, 50, posBits, negBits, 20000000, *arena);
+
+    if (checkpoint.path.empty()) {
+        auto res = RunBidirectional(guideTable, alphabets, costs, maxCost, posBits, negBits, limits, *arena, reporter, 64);
+        res.dedupe = arena->Stats();
+        return checked(res);
+    }
+
+    Checkpoint state(checkpoint, checkpointFingerprint(costFun, maxCost, limits.buCacheCapacity, limits.tdCacheCapacity, pos, neg));
+    auto res = RunBidirectional(guideTable, alphabets, costs, maxCost, posBits, negBits, limits, *arena, reporter, 64, &state);
+    res.dedupe = arena->Stats();
+    state.Remove();
+    return checked(res);
+}
+
+class rei::Session::State
+{
+public:
+    State(const unsigned short* costFun, const unsigned short maxCost, const SearchLimits& limits) :
+        costs(costFun), maxCost(maxCost), limits(limits) {
+    }
+
+    Costs costs;
+    unsigned short maxCost;
+    SearchLimits limits;
+    SearchArena arena;
+
+    std::vector<std::string> pos, neg;
+    std::vector<std::string> ic;
+    std::set<char> alphabets;
+
+    GuideTable guideTable;
+    CS posBits, negBits;
+
+    std::unique_ptr<BottomUpSearch> bottomUp;
+
+    // update the guide table and the stored bottom-up levels to the current examples
+    bool update();
+
+    void setExampleBits();
+};
+
+void rei::Session::State::setExampleBits() {
+    posBits = CS();
+    negBits = CS();
+    for (auto& p : pos) posBits.set(indexOfWord(ic, p));
+    for (auto& n : neg) negBits.set(indexOfWord(ic, n));
+}
+
+bool rei::Session::State::update() {
+
+    auto newIC = generatingIC(pos, neg);
+    auto newAlphabets = findAlphabets(pos, neg);
+
+    // a new letter moves the alphabet entries of the cache, nothing can be kept
+    if (!bottomUp || bottomUp->Overflowed() || newAlphabets != alphabets) {
+
+        bottomUp.reset();
+        alphabets = newAlphabets;
+        ic = std::move(newIC);
+
+        posBits = CS();
+        negBits = CS();
+        if (!generatingGuideTable(guideTable, posBits, negBits, ic, pos, neg))
+            return false;
+
+        arena.Reserve(limits);
+        bottomUp = std::make_unique<BottomUpSearch>(guideTable, alphabets, costs, maxCost, posBits, negBits, limits.buCacheCapacity, arena);
+        return true;
+    }
+
+    // the new words were already infixes, only the goal changed and every stored level is kept
+    if (newIC.size() == ic.size()) {
+        setExampleBits();
+        bottomUp->Rewind(bottomUp->ResumeLevel());
+        return true;
+    }
+
+    std::vector<int> newIndex(ic.size());
+    std::vector<bool> isOld(newIC.size(), false);
+    for (size_t i = 0; i < ic.size(); i++) {
+        newIndex[i] = indexOfWord(newIC, ic[i]);
+        isOld[newIndex[i]] = true;
+    }
+
+    std::vector<int> newWords;
+    for (size_t i = 0; i < newIC.size(); i++)
+        if (!isOld[i]) newWords.push_back(static_cast<int>(i));
+
+    // levels above the first rejected duplicate may miss languages that the new infixes tell apart
+    bottomUp->Rewind(bottomUp->ExactLevel());
+
+    ic = std::move(newIC);
+    posBits = CS();
+    negBits = CS();
+    if (!generatingGuideTable(guideTable, posBits, negBits, ic, pos, neg)) {
+        bottomUp.reset();
+        return false;
+    }
+
+    bottomUp->Remap(newIndex, newWords);
+    return true;
+}
+
+rei::Session::Session(const unsigned short* costFun, const unsigned short maxCost, const SearchLimits& limits) :
+    state(std::make_unique<State>(costFun, maxCost, limits)) {
+}
+
+rei::Session::~Session() = default;
+
+bool rei::Session::AddPositive(const std::string& word) {
+    if (std::find(state->neg.begin(), state->neg.end(), word) != state->neg.end()) return false;
+    if (std::find(state->pos.begin(), state->pos.end(), word) == state->pos.end()) state->pos.push_back(word);
+    return true;
+}
+
+bool rei::Session::AddNegative(const std::string& word) {
+    if (std::find(state->pos.begin(), state->pos.end(), word) != state->pos.end()) return false;
+    if (std::find(state->neg.begin(), state->neg.end(), word) == state->neg.end()) state->neg.push_back(word);
+    return true;
+}
+
+rei::Result rei::Session::Solve() {
 
-    //return RunBottomUp(guideTable, alphabets, costs, maxCost, posBits, negBits, 20000000);
+    auto& s = *state;
 
-    //return RunTopDown(guideTable, alphabets, costs, 50, posBits, negBits, 20000000);
+    std::string RE;
+    if (intialCheck(findAlphabets(s.pos, s.neg), s.pos, RE)) return Result(RE, 0, 0);
+
+    if (!s.update())
+        return Result("not_found", 0, 0);
+
+    const auto& guideTable = s.guideTable;
+
+    // Bottom-Up
+    int levels = 13;
+    BottomUpSearchResult buRes = {};
+
+    if (s.bottomUp->FindStored(buRes))
+        return Result(buRes.RE, guideTable.ICsize, buRes.allREs);
+
+    // the bottom-up search lives as long as the session, only the levels of this call are returned
+    size_t firstLevel = s.bottomUp->Stats().size();
+    auto withStats = [&](Result res, const TopDownSearch* topDown) {
+        const auto& levels = s.bottomUp->Stats();
+        res.stats.bottomUp.assign(levels.begin() + firstLevel, levels.end());
+        if (topDown) res.stats.topDown = topDown->Stats();
+        return res;
+    };
+
+    EnumerationState enumState = EnumerationState::NotFound;
+    while (s.bottomUp->ResumeLevel() <= s.costs.alpha + levels) {
+        enumState = s.bottomUp->EnumerateCostLevel(buRes);
+        if (enumState != EnumerationState::NotFound) break;
+    }
+
+    if (enumState == EnumerationState::Found)
+        return withStats(Result(buRes.RE, guideTable.ICsize, buRes.allREs), nullptr);
+
+    // Top-Down
+    int maxLevel = 50;
+    TopDownSearchResult tdRes = {};
+
+    TopDownSearch topDown(guideTable, std::make_shared<BottomUpResolver>(*s.bottomUp), maxLevel, s.posBits, s.negBits, s.limits.tdCacheCapacity, s.arena);
+
+    HeuristicConfigs heuristicConfigs;
+    heuristicConfigs.EnableRandomSamplingForAll(64);
+    topDown.SetHeuristic(heuristicConfigs);
+
+    // the stored languages are given through the frozen index, they are indexed again when the session grows
+    s.bottomUp->Freeze();
+    topDown.SetGiven(s.bottomUp->Frozen());
+    topDown.Push(CS::one(), tdRes);
+
+    do {
+        enumState = topDown.EnumerateLevel(tdRes);
+    } while (enumState == EnumerationState::NotFound);
 
-    return RunBidirectional(guideTable, alphabets, costs, maxCost, posBits, negBits, 64);
-}
\ No newline at end of file
+    if (enumState == EnumerationState::Found)
+        return withStats(Result(tdRes.RE, guideTable.ICsize, tdRes.allCS + buRes.allREs), &topDown);
+    else
+        return withStats(Result("not_found", guideTable.ICsize, tdRes.allCS + buRes.allREs), &topDown);
+}
@@ -1,5 +1,7 @@
 #include <rei_common.hpp>
 
+#include <regex_match.hpp>
+
 std::set<char> rei::findAlphabets(const std::vector<std::string>& pos, const std::vector<std::string>& neg) {
     std::set<char> alphabet;
     for (auto& word : pos) for (auto ch : word) alphabet.insert(ch);
@@ -20,4 +22,32 @@ bool rei::intialCheck(std::set<char> alphabets, const std::vector<std::string>&
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+CS rei::languageOf(const GuideTable& guideTable, const std::set<char>& alphabets, const std::string& pattern) {
+    if (pattern == "eps") return CS::one();
+    if (pattern == "Empty") return CS();
+
+    Parser parser(pattern);
+    RegexTree tree = parser.parse();
+
+    // the operands of a node come before it, one pass over the nodes evaluates the root last
+    std::vector<CS> languages(tree.Size());
+    for (int i = 0; i < tree.Size(); i++) {
+        const RegexNode& node = tree[i];
+        switch (node.tag) {
+        case RegexTag::Char: {
+            // the letters follow eps in the IC, a letter that is in no example matches none of them
+            auto it = alphabets.find(node.c);
+            if (it != alphabets.end()) languages[i].set(1 + static_cast<int>(std::distance(alphabets.begin(), it)));
+            break;
+        }
+        case RegexTag::Or: languages[i] = processOr(languages[node.left], languages[node.right]); break;
+        case RegexTag::And: languages[i] = languages[node.left] & languages[node.right]; break;
+        case RegexTag::Concat: languages[i] = processConcatenate(guideTable, languages[node.left], languages[node.right]); break;
+        case RegexTag::Star: languages[i] = processStar(guideTable, languages[node.left]); break;
+        case RegexTag::Optional: languages[i] = processQuestion(languages[node.left]); break;
+        }
+    }
+    return languages[tree.Root()];
+}
@@ -0,0 +1,68 @@
+#include <search_arena.hpp>
+
+#include <limits>
+#include <algorithm>
+
+void rei::SearchArena::Reserve(const SearchLimits& limits) {
+
+    buVisited.SetMode(limits.dedupe);
+    tdVisited.SetMode(limits.dedupe);
+
+    // the contexts index one past the capacity
+    if (limits.buCacheCapacity > buCapacity) {
+        buCapacity = limits.buCacheCapacity;
+        buCache.Reserve(buCapacity + 1);
+        buProvenance.reset(new Provenance[buCapacity + 1]);
+    }
+
+    if (limits.tdCacheCapacity > tdCapacity) {
+        tdCapacity = limits.tdCacheCapacity;
+        tdCache.reset(new CS[tdCapacity + 2]);
+        tdStatus.reset(new int[tdCapacity + 2]);
+        tdParentIdx.reset(new int[tdCapacity + 2]);
+    }
+}
+
+size_t rei::SearchArena::Bytes() const {
+    size_t bytes = 0;
+    if (buCapacity >= 0) bytes += (buCapacity + 1) * sizeof(Provenance) + buCache.Bytes();
+    if (tdCapacity >= 0) bytes += (tdCapacity + 2) * (sizeof(CS) + 2 * sizeof(int));
+    bytes += buVisited.Bytes() + tdVisited.Bytes() + buFrozen.Bytes();
+    return bytes;
+}
+
+rei::DedupeStats rei::SearchArena::Stats() const {
+    DedupeStats stats = buVisited.Stats();
+    stats += tdVisited.Stats();
+    return stats;
+}
+
+int rei::SearchLimits::DefaultBottomUpCapacity() {
+    // at most 256 MiB of languages, only wide CS types go below the 2M default
+    return static_cast<int>(std::min<size_t>(2000000, (size_t(256) << 20) / sizeof(CS)));
+}
+
+int rei::SearchLimits::DefaultTopDownCapacity() {
+    return static_cast<int>(std::min<size_t>(8000000, (size_t(1) << 30) / sizeof(CS)));
+}
+
+rei::SearchLimits rei::SearchLimits::FromMemoryBudget(size_t bytes, DedupeMode dedupe) {
+
+    // cache slot + indices + the table slots that point to it (kept at most half full, and doubled when growing).
+    // a bottom-up language takes a whole CS at most, the sparse ones far less
+    const size_t key = dedupe == DedupeMode::Exact ? sizeof(CS) : sizeof(Fingerprint);
+    const size_t slot = key + 2 * sizeof(int);
+    const size_t buEntry = sizeof(CS) + 2 * sizeof(int) + 4 * slot;
+    const size_t tdEntry = sizeof(CS) + 2 * sizeof(int) + 4 * slot;
+
+    auto clamp = [](size_t v) {
+        return static_cast<int>(std::clamp<size_t>(v, 1024, std::numeric_limits<int>::max() - 2));
+    };
+
+    // keep the default 1:4 ratio between the two searches
+    SearchLimits limits;
+    limits.dedupe = dedupe;
+    limits.buCacheCapacity = clamp(bytes / 5 / buEntry);
+    limits.tdCacheCapacity = clamp(bytes / 5 * 4 / tdEntry);
+    return limits;
+}
@@ -1,68 +1,69 @@
 #include <top_down.hpp>
 
+#include <chrono>
+
 #include <cs_utils.h>
+#include <logger.hpp>
+#include <search_stats.h>
 
-#define LOG_OP(levelnum, op_string, allCS, counter) \
-        printf("Level %-2d | (%s) | AllCS: %-11llu | S %-5llu | NV %-11llu | V %-11llu | C %-11llu | SS %-5llu | G %-5llu \n", \
-            levelnum, op_string.c_str() ,allCS,  counter.solved, counter.notVisited, counter.visited, counter.cyclic, counter.selfSolved, counter.given);
+// a record per operation of a level, only built with LOG_LEVEL=debug
+#define LOG_OP(levelnum, op, allCS, counter) \
+        LOG_DEBUG("Level %-2d | (%s) | AllCS: %-11llu | S %-5llu | NV %-11llu | V %-11llu | C %-11llu | SS %-5llu | G %-5llu \n", \
+            levelnum, shortName(op), static_cast<unsigned long long>(allCS), static_cast<unsigned long long>(counter.solved), \
+            static_cast<unsigned long long>(counter.notVisited), static_cast<unsigned long long>(counter.visited), \
+            static_cast<unsigned long long>(counter.cyclic), static_cast<unsigned long long>(counter.selfSolved), \
+            static_cast<unsigned long long>(counter.given))
 
 using namespace rei;
 
-rei::TopDownSearch::Context::Context(int cache_capacity)
+rei::TopDownSearch::Context::Context(SearchArena& arena) : visited(arena.TopDownVisited())
 {
-    status = new int[cache_capacity + 2];
-    parentIdx = new int[cache_capacity + 2];
-    cache = new CS[cache_capacity + 2];
+    visited.Clear();
+
+    status = arena.TopDownStatus();
+    parentIdx = arena.TopDownParentIdx();
+    cache = arena.TopDownCache();
 
     lastIdx = 0;
     allCS = 0;
+    goalChecks = 0;
     counter = {};
 }
 
-rei::TopDownSearch::Context::~Context()
-{
-    delete[] cache;
-    delete[] parentIdx;
-    delete[] status;
-}
-
 void rei::TopDownSearch::Context::AddSolutionSet(const std::vector<CS>& solutionSet) {
     for (size_t i = 0; i < solutionSet.size(); i++)
-        visited[solutionSet[i]] = -1;
+        visited[solutionSet[i]] = given && given->Contains(solutionSet[i]) ? Solved : SolutionSet;
 }
 
 bool rei::TopDownSearch::Context::AddSolvedNode(const CS& cs, int& idx) {
-    if (visited.find(cs) == visited.end())
-    {
-        visited[cs] = -1;
-        solved.insert(cs);
-        return false;
-    }
-    else
-    {
-        // replace in the graph and do the check!
-        return false;
-    }
+    // a language that is already in the graph is left as it is
+    visited.Insert(cs, Solved);
+    return false;
 }
 
 bool rei::TopDownSearch::Context::InsertAndCheck(int parentIdx, CS left, CS right)
 {
     allCS += 2;
 
-    auto lt = getNodeType(left);
-    auto rt = getNodeType(right);
+    // the children are written at lastIdx and lastIdx + 1 and only kept when neither of them closes a cycle
+    auto lt = insert(left, parentIdx, lastIdx);
+    auto rt = insert(right, parentIdx, lastIdx + 1);
 
     counter.update(lt);
     counter.update(rt);
 
     if (lt == NodeType::Cyclic || rt == NodeType::Cyclic)
+    {
+        if (lt == NodeType::NotVistied) *visited.Find(left) = Dropped;
+        if (rt == NodeType::NotVistied) *visited.Find(right) = Dropped;
         return false;
+    }
 
-    insert(lt, left, parentIdx);
-    insert(rt, right, parentIdx);
+    lastIdx += 2;
 
     if ((static_cast<int>(lt) > 2) && (static_cast<int>(rt) > 2))
     {
+        goalChecks++;
         if (parentIdx == -1) return true;
         return recursiveCheck(parentIdx, lastIdx - 2);
     }
@@ -100,55 +101,109 @@ int rei::TopDownSearch::Context::GetLastOutmostParent() {
     return pIdx % 2 == 0 ? pIdx : pIdx - 1;
 }
 
-rei::TopDownSearch::Context::NodeType rei::TopDownSearch::Context::getNodeType(const CS& cs)
+void rei::TopDownSearch::Context::Save(CheckpointWriter& writer) const {
+    writer.Write(lastIdx);
+    writer.Write(allCS);
+    writer.Write(counter);
+
+    writer.WriteArray(cache, lastIdx);
+    writer.WriteArray(status, lastIdx);
+    writer.WriteArray(parentIdx, lastIdx);
+
+    visited.Save(writer);
+}
+
+bool rei::TopDownSearch::Context::Load(CheckpointReader& reader, int cache_capacity, Loaded& loaded) const {
+    reader.Read(loaded.lastIdx);
+    reader.Read(loaded.allCS);
+    reader.Read(loaded.counter);
+
+    int n = loaded.lastIdx;
+    if (!reader.Good() || n < 2 || n > cache_capacity + 2) return false;
+
+    loaded.cache.resize(n);
+    loaded.status.resize(n);
+    loaded.parentIdx.resize(n);
+    if (!reader.ReadArray(loaded.cache.data(), n)) return false;
+    if (!reader.ReadArray(loaded.status.data(), n)) return false;
+    if (!reader.ReadArray(loaded.parentIdx.data(), n)) return false;
+    if (!visited.Load(reader, loaded.visited)) return false;
+
+    // every index of the file points into the graph. a parent and an original node come before the nodes that
+    // refer to them, so the walks up the graph end. the indices 0 and 1 are reserved and never read
+    for (int i = 2; i < n; i++) {
+        int s = loaded.status[i], p = loaded.parentIdx[i];
+        if (s == 1 || s >= n || (s < -1 && -s >= i)) return false;
+        if (p != -1 && (p < 2 || p >= i)) return false;
+    }
+
+    bool valid = true;
+    loaded.visited.ForEachValue([&](int value) {
+        if (value < Dropped || (value >= 0 && value < 2) || value >= n) valid = false;
+    });
+    return valid;
+}
+
+void rei::TopDownSearch::Context::Assign(Loaded& loaded) {
+    std::copy(loaded.cache.begin(), loaded.cache.end(), cache);
+    std::copy(loaded.status.begin(), loaded.status.end(), status);
+    std::copy(loaded.parentIdx.begin(), loaded.parentIdx.end(), parentIdx);
+    visited.Swap(loaded.visited);
+
+    lastIdx = loaded.lastIdx;
+    allCS = loaded.allCS;
+    counter = loaded.counter;
+}
+
+rei::TopDownSearch::Context::NodeType rei::TopDownSearch::Context::insert(const CS& cs, int pIdx, int idx)
 {
-    auto vit = visited.find(cs);
-    if (vit == visited.end())
-        return NodeType::NotVistied;
-    if (solved.find(cs) == solved.end())
+    // the one probe of the visited table, a language seen for the first time takes the node index
+    auto [value, added] = visited.Insert(cs, idx);
+
+    NodeType nodeType;
+    if (added || *value == Dropped)
     {
-        if ((*vit).second == -1) // we only test the solution set
-            return NodeType::Cyclic;
-        else
-            return NodeType::Vistied;
+        *value = idx;
+        nodeType = NodeType::NotVistied;
+        if (given && given->Contains(cs))
+        {
+            *value = Solved;
+            nodeType = NodeType::Given;
+        }
     }
+    else if (*value == SolutionSet)
+        return NodeType::Cyclic;
+    else if (*value == Solved)
+        nodeType = NodeType::Given;
     else
-    {
-        if ((*vit).second == -1)
-            return NodeType::Given;
-        else
-            return NodeType::SelfSolved;
-    }
-}
+        nodeType = status[*value] > 1 ? NodeType::SelfSolved : NodeType::Vistied;
 
-void rei::TopDownSearch::Context::insert(NodeType nodeType, CS cs, int pIdx)
-{
     switch (nodeType) {
     case NodeType::NotVistied:
-        cache[lastIdx] = cs;
-        visited[cs] = lastIdx;
-        status[lastIdx] = 0;
+        cache[idx] = cs;
+        status[idx] = 0;
         break;
     case NodeType::Vistied:
-        status[lastIdx] = -visited.at(cs);
-        break;
     case NodeType::SelfSolved:
-        status[lastIdx] = -visited.at(cs);
-        idxToSolved[lastIdx] = cs;
+        cache[idx] = CS();
+        status[idx] = -*value;
         break;
     case NodeType::Given:
-        status[lastIdx] = -1;
-        idxToSolved[lastIdx] = cs;
+        cache[idx] = cs;
+        status[idx] = -1;
+        break;
+    default:
         break;
     }
 
-    parentIdx[lastIdx++] = pIdx;
+    parentIdx[idx] = pIdx;
+    return nodeType;
 }
 
 bool rei::TopDownSearch::Context::isSolved(int idx) {
     auto s = status[idx];
     if (s == -1 || s > 1) return true;
-    if (s < -1) return idxToSolved.find(-s) != idxToSolved.end();
+    if (s < -1) return status[-s] > 1;
     return false;
 }
 
@@ -156,10 +211,8 @@ bool rei::TopDownSearch::Context::recursiveCheck(int index, int lcIdx)
 {
     if (isSolved(index)) return false;
 
-    // we can reconstruct the cs recursively, we don't need cache
-    solved.insert(cache[index]);
+    // the language is solved once its node points to the children that solve it
     status[index] = lcIdx;
-    idxToSolved[index] = cache[index];
 
     counter.solved++;
 
@@ -183,9 +236,9 @@ int rei::TopDownSearch::Context::getOutmostParent(int index) {
 
 
 rei::TopDownSearch::TopDownSearch(const rei::GuideTable& guideTable,
-    std::shared_ptr<rei::CSResolverInterface> resolver, int maxLevel, const CS& posBits, const CS& negBits, int cache_capacity) :
-    guideTable(guideTable), resolver(resolver), partitioner(maxLevel), context(cache_capacity),
-    maxLevel(maxLevel), posBits(posBits), negBits(negBits), cache_capacity(cache_capacity) {
+    std::shared_ptr<rei::CSResolverInterface> resolver, int maxLevel, const CS& posBits, const CS& negBits, int cache_capacity, SearchArena& arena) :
+    maxLevel(maxLevel), cache_capacity(cache_capacity), posBits(posBits), negBits(negBits), guideTable(guideTable), resolver(resolver),
+    partitioner(maxLevel), context(arena), arena(arena) {
 
     // the index 0 and 1 are reserved for checking
     partitioner.start(0, Operation::Question) = 2;
@@ -203,10 +256,18 @@ bool rei::TopDownSearch::Push(const CS& cs, TopDownSearchResult& res) {
         return false;
 }
 
+void rei::TopDownSearch::SetGiven(const FrozenLanguageIndex& given) {
+    context.given = &given;
+}
+
 EnumerationState rei::TopDownSearch::EnumerateLevel(TopDownSearchResult& res)
 {
     if (level == maxLevel) return EnumerationState::End;
 
+    auto startTime = std::chrono::steady_clock::now();
+    levelStats.emplace_back();
+    levelStats.back().level = level;
+
     EnumerationState enumState;
     int solvedIdx;
 
@@ -238,6 +299,11 @@ EnumerationState rei::TopDownSearch::EnumerateLevel(TopDownSearchResult& res)
     if (enumState == EnumerationState::Found)
         res.RE = constructDownward(solvedIdx);
     res.allCS = context.lastIdx;
+    res.level = level;
+
+    auto& stats = levelStats.back();
+    stats.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    stats.arenaBytes = arena.Bytes();
 
     level++;
     return enumState;
@@ -248,22 +314,77 @@ void rei::TopDownSearch::SetHeuristic(HeuristicConfigs configs)
     heuristicConfigs = configs;
 }
 
-std::vector<CS> rei::TopDownSearch::randomSampleSolutionSet(size_t maxSamples, uint64_t seed)
+uint64_t rei::TopDownSearch::Candidates() const
 {
-    std::vector<int> dontCareBits;
-    dontCareBits.reserve(guideTable.ICsize);
+    return context.allCS;
+}
 
-    const CS combined = posBits | negBits;
-    for (int i = 0; i < guideTable.ICsize; ++i)
-    {
-        const CS bitMask = CS::one() << i;
-        if ((bitMask & combined) == CS())
-        {
-            dontCareBits.push_back(i);
-        }
-    }
+double rei::TopDownSearch::VisitedLoad() const
+{
+    return context.visited.LoadFactor();
+}
 
-    const size_t numDontCareBits = dontCareBits.size();
+const std::vector<LevelStats>& rei::TopDownSearch::Stats() const
+{
+    return levelStats;
+}
+
+OperationStats rei::TopDownSearch::counters() const
+{
+    OperationStats stats;
+    stats.candidates = context.allCS;
+    stats.duplicates = context.counter.visited + context.counter.selfSolved + context.counter.cyclic;
+    stats.goalChecks = context.goalChecks;
+    stats.inversions = inversions;
+    stats.cappedInversions = cappedInversions;
+    stats.inverted = inverted;
+    stats.lookups = context.visited.Lookups();
+    stats.probes = context.visited.Probes();
+    return stats;
+}
+
+void rei::TopDownSearch::countInversion(size_t results, bool sampled, int maxSamples)
+{
+    inversions++;
+    inverted += results;
+    if (sampled && results >= static_cast<size_t>(maxSamples)) cappedInversions++;
+}
+
+void rei::TopDownSearch::Save(CheckpointWriter& writer) const
+{
+    writer.Write(level);
+    context.Save(writer);
+    partitioner.Save(writer);
+}
+
+bool rei::TopDownSearch::Load(CheckpointReader& reader)
+{
+    int fileLevel;
+    if (!reader.Read(fileLevel) || fileLevel < 0 || fileLevel > maxLevel) return false;
+
+    // nothing is changed until the whole section was read
+    Context::Loaded loaded;
+    std::vector<int> points;
+    if (!context.Load(reader, cache_capacity, loaded) || !partitioner.Load(reader, points, loaded.lastIdx)) return false;
+
+    context.Assign(loaded);
+    partitioner.Assign(points);
+    level = fileLevel;
+    return true;
+}
+
+// the bits of the IC that are neither a positive nor a negative, a solution can take any subset of them
+CS dontCareBits(const CS& posBits, const CS& negBits, int ICsize) {
+    CS dontCare = firstBits(ICsize);
+    dontCare.andNotAssign(posBits | negBits, CS::wordsFor(ICsize));
+    return dontCare;
+}
+
+std::vector<CS> rei::TopDownSearch::randomSampleSolutionSet(size_t maxSamples, uint64_t seed)
+{
+    SubsetEnumerator subsets(dontCareBits(posBits, negBits, guideTable.ICsize), guideTable.Words());
+
+    const size_t numDontCareBits = subsets.Count();
 
     if (numDontCareBits < 64 && (1ULL << numDontCareBits) <= maxSamples)
         return generateSolutionSet();
@@ -272,13 +393,12 @@ std::vector<CS> rei::TopDownSearch::randomSampleSolutionSet(size_t maxSamples, u
     result.reserve(maxSamples);
 
     std::mt19937_64 rng(seed);
-    std::bernoulli_distribution coin(0.5);
 
     std::unordered_set<CS> visited;
 
     while (result.size() < maxSamples) {
 
-        CS submask = getRandom(dontCareBits, rng, coin) | posBits;
+        CS submask = subsets.Random(rng, posBits);
 
         if (visited.insert(submask).second)
             result.emplace_back(submask);
@@ -289,38 +409,18 @@ std::vector<CS> rei::TopDownSearch::randomSampleSolutionSet(size_t maxSamples, u
 
 std::vector<CS> rei::TopDownSearch::generateSolutionSet()
 {
-    std::vector<int> dontCareBits;
-    dontCareBits.reserve(guideTable.ICsize);
-
-    const CS combined = posBits | negBits;
-    for (int i = 0; i < guideTable.ICsize; ++i)
-    {
-        const CS bitMask = CS::one() << i;
-        if ((bitMask & combined) == CS())
-        {
-            dontCareBits.push_back(i);
-        }
-    }
+    SubsetEnumerator subsets(dontCareBits(posBits, negBits, guideTable.ICsize), guideTable.Words());
 
-    const size_t numDontCareBits = dontCareBits.size();
-    const size_t numCombinations = 1ULL << numDontCareBits;
+    const size_t numCombinations = 1ULL << subsets.Count();
 
     std::vector<CS> combinations;
     combinations.reserve(numCombinations);
 
+    CS combination = posBits;
     for (size_t subset = 0; subset < numCombinations; ++subset)
     {
-        CS combination = posBits;
-
-        for (size_t bit = 0; bit < numDontCareBits; ++bit)
-        {
-            if (subset & (1ULL << bit))
-            {
-                combination |= (CS::one() << dontCareBits[bit]);
-            }
-        }
-
         combinations.push_back(combination);
+        subsets.Next(combination);
     }
 
     return combinations;
@@ -328,20 +428,28 @@ std::vector<CS> rei::TopDownSearch::generateSolutionSet()
 
 EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, int startPIdx, int& idx, bool overrideParent, int opIdx) {
 
+    // only the nodes that own their language are inverted, the redirects are empty and the given leaves are done
+    auto expandable = [&](const CS& parent, int pIdx) {
+        return parent != CS() && (overrideParent || context.status[pIdx] >= 0);
+    };
+
+    OperationTimer timer(levelStats.back(), [this] { return counters(); }, Operation::Question);
+
     // Question
     int pIdx = startPIdx - 1;
     for (const auto& parent : CSs)
     {
         pIdx++;
-        if (parent == CS()) continue;
+        if (!expandable(parent, pIdx)) continue;
 
-        if (parent & CS::one())
+        if (parent.test(0))
         {
+            countInversion(1, false, 0);
             if (context.lastIdx > cache_capacity) return EnumerationState::End;
 
             if (context.InsertAndCheck(overrideParent ? opIdx : pIdx, parent & (~CS::one())))
             {
-                LOG_OP(level, to_string(Operation::Question), context.allCS, context.counter);
+                LOG_OP(level, Operation::Question, context.allCS, context.counter);
                 partitioner.end(level, Operation::Question) = INT_MAX;
                 idx = context.GetLastOutmostParent();
                 return EnumerationState::Found;
@@ -349,16 +457,17 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
         }
     }
     partitioner.end(level, Operation::Question) = context.lastIdx;
-    LOG_OP(level, to_string(Operation::Question), context.allCS, context.counter);
+    LOG_OP(level, Operation::Question, context.allCS, context.counter);
 
     // Star
+    timer.Next(Operation::Star);
     pIdx = startPIdx - 1;
     for (const auto& parent : CSs)
     {
         pIdx++;
-        if (parent == CS()) continue;
+        if (!expandable(parent, pIdx)) continue;
 
-        if (parent & CS::one())
+        if (parent.test(0))
         {
             std::vector<CS> childs;
 
@@ -366,6 +475,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
                 childs = rei::revertStarRandom(parent, heuristicConfigs.invertStarMaxSamples, guideTable);
             else
                 childs = rei::revertStar(parent, guideTable);
+            countInversion(childs.size(), heuristicConfigs.invertStarUseRandomSampling, heuristicConfigs.invertStarMaxSamples);
 
             for (size_t i = 0; i < childs.size(); i++)
             {
@@ -373,7 +483,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
 
                 if (context.InsertAndCheck(overrideParent ? opIdx : pIdx, childs[i]))
                 {
-                    LOG_OP(level, to_string(Operation::Star), context.allCS, context.counter);
+                    LOG_OP(level, Operation::Star, context.allCS, context.counter);
                     partitioner.end(level, Operation::Star) = INT_MAX;
                     idx = context.GetLastOutmostParent();
                     return EnumerationState::Found;
@@ -382,14 +492,15 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
         }
     }
     partitioner.end(level, Operation::Star) = context.lastIdx;
-    LOG_OP(level, to_string(Operation::Star), context.allCS, context.counter);
+    LOG_OP(level, Operation::Star, context.allCS, context.counter);
 
     // Concatenate
+    timer.Next(Operation::Concatenate);
     pIdx = startPIdx - 1;
     for (const auto& parent : CSs)
     {
         pIdx++;
-        if (parent == CS()) continue;
+        if (!expandable(parent, pIdx)) continue;
 
         std::vector<Pair<CS>> pairs;
 
@@ -397,6 +508,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
             pairs = revertConcatRandom(parent, heuristicConfigs.invertConcatMaxSamples, guideTable);
         else
             pairs = revertConcat(parent, guideTable);
+        countInversion(pairs.size(), heuristicConfigs.invertConcatUseRandomSampling, heuristicConfigs.invertConcatMaxSamples);
 
         for (size_t i = 0; i < pairs.size(); i++)
         {
@@ -406,7 +518,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
 
             if (context.InsertAndCheck(overrideParent ? opIdx : pIdx, pair.left, pair.right))
             {
-                LOG_OP(level, to_string(Operation::Concatenate), context.allCS, context.counter);
+                LOG_OP(level, Operation::Concatenate, context.allCS, context.counter);
                 partitioner.end(level, Operation::Concatenate) = INT_MAX;
                 idx = context.GetLastOutmostParent();
                 return EnumerationState::Found;
@@ -414,14 +526,15 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
         }
     }
     partitioner.end(level, Operation::Concatenate) = context.lastIdx;
-    LOG_OP(level, to_string(Operation::Concatenate), context.allCS, context.counter);
+    LOG_OP(level, Operation::Concatenate, context.allCS, context.counter);
 
     // Or
+    timer.Next(Operation::Or);
     pIdx = startPIdx - 1;
     for (const auto& parent : CSs)
     {
         pIdx++;
-        if (parent == CS()) continue;
+        if (!expandable(parent, pIdx)) continue;
 
         std::vector<Pair<CS>> pairs;
 
@@ -429,6 +542,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
             pairs = revertOrRandom(parent, heuristicConfigs.invertOrMaxSamples, guideTable.ICsize);
         else
             pairs = revertOr(parent);
+        countInversion(pairs.size(), heuristicConfigs.invertOrUseRandomSampling, heuristicConfigs.invertOrMaxSamples);
 
         for (size_t i = 0; i < pairs.size(); i++)
         {
@@ -438,7 +552,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
 
             if (context.InsertAndCheck(overrideParent ? opIdx : pIdx, pair.left, pair.right))
             {
-                LOG_OP(level, to_string(Operation::Or), context.allCS, context.counter);
+                LOG_OP(level, Operation::Or, context.allCS, context.counter);
                 partitioner.end(level, Operation::Or) = INT_MAX;
                 idx = context.GetLastOutmostParent();
                 return EnumerationState::Found;
@@ -446,7 +560,7 @@ EnumerationState rei::TopDownSearch::enumerateLevel(const std::span<CS>& CSs, in
         }
     }
     partitioner.end(level, Operation::Or) = context.lastIdx;
-    LOG_OP(level, to_string(Operation::Or), context.allCS, context.counter);
+    LOG_OP(level, Operation::Or, context.allCS, context.counter);
 
     return EnumerationState::NotFound;
 }
@@ -465,7 +579,7 @@ std::string rei::TopDownSearch::constructDownward(int index)
 {
     std::string left;
     if (context.status[index] == -1)
-        left = resolver->resolve(context.idxToSolved.at(index));
+        left = resolver->resolve(context.cache[index]);
     else
     {
         auto ls = context.status[index];
@@ -494,7 +608,7 @@ std::string rei::TopDownSearch::constructDownward(int index)
 
     std::string right;
     if (context.status[++index] == -1)
-        right = resolver->resolve(context.idxToSolved.at(index));
+        right = resolver->resolve(context.cache[index]);
     else
     {
         auto rs = context.status[index];
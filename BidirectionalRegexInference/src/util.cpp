@@ -3,6 +3,14 @@
 #include <fstream>
 #include <regex_match.hpp>
 
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
 bool rei::readStream(std::istream& stream, std::vector<std::string>& pos, std::vector<std::string>& neg) {
     std::string line;
 
@@ -64,43 +72,75 @@ bool rei::readFile(const std::string& fileName, std::vector<std::string>& pos, s
 
 }
 
-void  count(shared_ptr<Regex> node, rei::OperationsCount& counts) {
-    if (!node) return;
-    if (auto altr = dynamic_cast<Or*>(node.get())) {
-        counts.alternation++;
-        count(altr->left, counts);
-        count(altr->right, counts);
-    }
-    else if (auto inter = dynamic_cast<And*>(node.get())) {
-        counts.intersection++;
-        count(inter->left, counts);
-        count(inter->right, counts);
-    }
-    else if (auto concat = dynamic_cast<Concat*>(node.get())) {
-        counts.concat++;
-        count(concat->left, counts);
-        count(concat->right, counts);
-    }
-    else if (auto star = dynamic_cast<Star*>(node.get())) {
-        counts.star++;
-        count(star->node, counts);
-    }
-    else if (auto question = dynamic_cast<Optional*>(node.get())) {
-        counts.question++;
-        count(question->node, counts);
-    }
-    else if (auto character = dynamic_cast<Char*>(node.get())) {
-        counts.alpha++;
-    }
-    else {
-        printf("Unknown type\n");
-    }
-}
-
 rei::OperationsCount  rei::countOpreations(const std::string& pattern) {
     Parser parser(pattern);
-    shared_ptr<Regex> tree = parser.parse();
+    RegexTree tree = parser.parse();
     rei::OperationsCount counts;
-    count(tree, counts);
+    // every node of the tree is reachable from the root
+    for (int i = 0; i < tree.Size(); i++) {
+        switch (tree[i].tag) {
+        case RegexTag::Or: counts.alternation++; break;
+        case RegexTag::And: counts.intersection++; break;
+        case RegexTag::Concat: counts.concat++; break;
+        case RegexTag::Star: counts.star++; break;
+        case RegexTag::Optional: counts.question++; break;
+        case RegexTag::Char: counts.alpha++; break;
+        }
+    }
     return counts;
-}
\ No newline at end of file
+}
+int rei::calculateCost(const std::string& pattern, const unsigned short* costFun) {
+    auto counts = countOpreations(pattern);
+    int count = 0;
+    count += counts.alpha * costFun[0];
+    count += counts.question * costFun[1];
+    count += counts.star * costFun[2];
+    count += counts.concat * costFun[3];
+    count += counts.alternation * costFun[4];
+    return count;
+}
+
+std::string rei::escapeJson(const std::string& s) {
+    std::string res;
+    for (auto c : s) {
+        if (c == '"' || c == '\\') res += '\\';
+        res += c;
+    }
+    return res;
+}
+
+std::string rei::toJson(const OperationStats& stats) {
+    std::ostringstream out;
+    out << "{\"candidates\":" << stats.candidates << ",\"duplicates\":" << stats.duplicates
+        << ",\"goalChecks\":" << stats.goalChecks << ",\"inversions\":" << stats.inversions
+        << ",\"cappedInversions\":" << stats.cappedInversions << ",\"inverted\":" << stats.inverted
+        << ",\"lookups\":" << stats.lookups << ",\"probes\":" << stats.probes << ",\"time\":" << stats.time << "}";
+    return out.str();
+}
+
+std::string rei::toJson(const LevelStats& stats) {
+    static const char* names[] = { "question", "star", "concatenate", "or" };
+
+    std::ostringstream out;
+    out << "{\"level\":" << stats.level << ",\"time\":" << stats.time << ",\"arenaBytes\":" << stats.arenaBytes << ",\"operations\":{";
+    for (int op = 0; op < 4; op++)
+        out << (op ? "," : "") << "\"" << names[op] << "\":" << toJson(stats.operations[op]);
+    out << "}}";
+    return out.str();
+}
+
+size_t rei::residentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.WorkingSetSize;
+    return 0;
+#elif defined(__linux__)
+    // the second field of statm is the resident set in pages
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
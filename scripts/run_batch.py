@@ -1,15 +1,10 @@
 import os
 import re
+import json
 import subprocess
 import csv
 import sys
 
-# Regex patterns
-RE_PATTERN = re.compile(r'RE:\s*"(.*)"')
-COST_PATTERN = re.compile(r'Cost:\s*(\d+)')
-RES_PATTERN = re.compile(r'^REs:\s*([0-9]+)\s*$', re.MULTILINE)
-TIME_PATTERN = re.compile(r'Running Time:\s*([\d.]+)\s*s')
-
 def natural_sort_key(s):
     return [
         int(text) if text.isdigit() else text.lower()
@@ -35,7 +30,8 @@ def run_bdres_on_directory(directory, csv_writer, csv_file):
         cmd = [
             "../BidirectionalRegexInference/build/Release/RegexInference.exe",
             filepath,
-            "1", "1", "1", "1", "1", "500"
+            "1", "1", "1", "1", "1", "500",
+            "--format", "ndjson"
         ]
 
         try:
@@ -47,23 +43,20 @@ def run_bdres_on_directory(directory, csv_writer, csv_file):
                 text=True,
                 check=True
             )
-            output = completed.stdout
-
-            re_match = RE_PATTERN.search(output)
-            cost_match = COST_PATTERN.search(output)
-            res_match = RES_PATTERN.search(output)
-            time_match = TIME_PATTERN.search(output)
+            # one JSON object per line, the phases and then the result
+            records = [json.loads(line) for line in completed.stdout.splitlines() if line.startswith("{")]
+            result = next((r for r in records if r["type"] == "result"), None)
 
-            if not all([re_match, cost_match, res_match, time_match]):
-                print(f"Warning: Could not fully parse output for {filename}")
+            if result is None:
+                print(f"Warning: Could not find the result for {filename}")
                 continue
 
             row = [
                 base_name,
-                re_match.group(1),
-                int(cost_match.group(1)),
-                int(res_match.group(1)),
-                float(time_match.group(1))
+                result["RE"],
+                result["cost"],
+                result["REs"],
+                result["time"]
             ]
 
             # write row immediately